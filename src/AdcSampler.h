@@ -0,0 +1,142 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/interrupt.h> // Для ISR()
+#include <util/atomic.h>   // Для ATOMIC_BLOCK
+
+/*
+ * Фоновый опрос АЦП по прерыванию
+ * Реализует:
+ * - Непрерывное преобразование (free-running) с прерыванием по завершению
+ * - Поочередный опрос до MAX_CHANNELS аналоговых входов (round-robin)
+ * - Передискретизацию: 16 отсчетов суммируются и децимируются до 12 бит
+ * - Кольцевой буфер децимированных значений на каждый канал
+ *
+ * После begin() функция analogRead() больше не используется: АЦП работает
+ * сам по себе, а главный цикл только читает готовое усредненное значение.
+ */
+class AdcSampler {
+public:
+    static const uint8_t MAX_CHANNELS = 4;                                 // Максимум опрашиваемых входов
+    static const uint8_t OVERSAMPLE_BITS = 2;                              // Дополнительные биты разрешения
+    static const uint8_t SAMPLES_PER_RESULT = 1 << (2 * OVERSAMPLE_BITS);  // 4^n отсчетов на +n бит
+    static const uint8_t RESULT_BITS = 10 + OVERSAMPLE_BITS;               // Разрядность результата
+    static const uint8_t RING_SIZE = 4;                                    // Размер кольцевого буфера канала
+    static const uint8_t SETTLE_SAMPLES = 2;                               // Отбрасываемые отсчеты после смены входа
+
+    /*
+     * Запуск АЦП в режиме непрерывного преобразования
+     * pins - массив аналоговых пинов (A0-A7), count - их количество
+     * Вызывать из setup(): init() ядра Arduino перенастраивает АЦП
+     * уже после глобальных конструкторов.
+     */
+    static void begin(const uint8_t* pins, uint8_t count) {
+        channelCount = (count > MAX_CHANNELS) ? MAX_CHANNELS : count;
+        for (uint8_t i = 0; i < channelCount; i++) {
+            uint8_t channel = (pins[i] >= A0) ? pins[i] - A0 : pins[i];
+            mux[i] = _BV(REFS0) | (channel & 0x07); // Опорное напряжение AVcc
+            if (channel < 6) {
+                DIDR0 |= _BV(channel); // Отключаем цифровой вход, чтобы снизить шум
+            }
+            memset(&channels[i], 0, sizeof(Channel));
+        }
+        current = 0;
+        accumulator = 0;
+        sampleCount = 0;
+        settleCount = SETTLE_SAMPLES;
+
+        ADMUX = mux[0];
+        ADCSRB = 0; // Источник запуска - free-running
+        // Прескалер 128: 125 кГц на АЦП, ~9600 преобразований в секунду
+        ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) |
+                 _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+    }
+
+    /*
+     * Проверка готовности данных канала
+     * Возвращает true, когда кольцевой буфер канала заполнен полностью
+     */
+    static bool isReady(uint8_t channel) {
+        return channels[channel].fill >= RING_SIZE;
+    }
+
+    /*
+     * Получение усредненного значения АЦП
+     * channel - номер канала в порядке, переданном в begin()
+     * Возвращает код разрядностью RESULT_BITS (0-4095)
+     */
+    static uint16_t read(uint8_t channel) {
+        uint16_t sum;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            sum = channels[channel].sum;
+        }
+        return (sum + RING_SIZE / 2) / RING_SIZE;
+    }
+
+    /*
+     * Обработка завершенного преобразования
+     * Вызывается только из обработчика прерывания ADC_vect
+     */
+    static void onConversion() {
+        uint16_t sample = ADC;
+        // В режиме free-running смена входа действует со следующего преобразования,
+        // поэтому первые отсчеты после переключения отбрасываются
+        if (settleCount) {
+            settleCount--;
+            return;
+        }
+
+        accumulator += sample;
+        if (++sampleCount < SAMPLES_PER_RESULT) return;
+
+        // Децимация: сумма 4^n отсчетов, сдвинутая на n бит
+        uint16_t result = accumulator >> OVERSAMPLE_BITS;
+        accumulator = 0;
+        sampleCount = 0;
+
+        // Скользящая сумма по кольцевому буферу канала
+        Channel& ch = channels[current];
+        ch.sum = ch.sum - ch.ring[ch.index] + result;
+        ch.ring[ch.index] = result;
+        if (++ch.index >= RING_SIZE) ch.index = 0;
+        if (ch.fill < RING_SIZE) ch.fill++;
+
+        // Переход к следующему входу
+        if (channelCount > 1) {
+            if (++current >= channelCount) current = 0;
+            ADMUX = mux[current];
+            settleCount = SETTLE_SAMPLES;
+        }
+    }
+
+private:
+    struct Channel {
+        uint16_t ring[RING_SIZE];       // Децимированные значения
+        uint16_t sum;                   // Сумма значений в кольцевом буфере
+        uint8_t index;                  // Позиция записи в кольцевом буфере
+        uint8_t fill;                   // Количество заполненных ячеек
+    };
+
+    static Channel channels[MAX_CHANNELS];
+    static uint8_t mux[MAX_CHANNELS];   // Значения ADMUX для каждого канала
+    static uint8_t channelCount;        // Количество опрашиваемых каналов
+    static uint8_t current;             // Текущий канал
+    static uint16_t accumulator;        // Сумма отсчетов текущего блока (16 x 1023 < 65536)
+    static uint8_t sampleCount;         // Количество отсчетов в текущем блоке
+    static uint8_t settleCount;         // Сколько отсчетов еще отбросить после смены входа
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    AdcSampler() = delete;
+};
+
+AdcSampler::Channel AdcSampler::channels[AdcSampler::MAX_CHANNELS];
+uint8_t AdcSampler::mux[AdcSampler::MAX_CHANNELS];
+uint8_t AdcSampler::channelCount = 0;
+uint8_t AdcSampler::current = 0;
+uint16_t AdcSampler::accumulator = 0;
+uint8_t AdcSampler::sampleCount = 0;
+uint8_t AdcSampler::settleCount = 0;
+
+// Прерывание по завершению преобразования АЦП
+ISR(ADC_vect) {
+    AdcSampler::onConversion();
+}
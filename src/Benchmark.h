@@ -0,0 +1,163 @@
+#pragma once
+#include <Arduino.h>
+#include <GyverNTC.h>          // Исходный способ пересчета для сравнения
+#include <stdio.h>             // snprintf - старый способ форматирования
+#include <stdlib.h>            // dtostrf
+#include "TemperatureSensor.h" // NtcLookup, NTC_SERIES_R, NTC_BETA
+#include "Format.h"
+#include "Display.h"           // Display::LINE_BUFFER
+
+/*
+ * Замеры длительности фрагментов кода в тактах процессора
+ * Реализует:
+ * - Счетчик тактов на Timer1 без предделителя (1 тик = 1 такт, 62.5 нс)
+ * - Сравнение пересчета NTC: GyverNTC::computeTemp() против таблицы NtcLookup
+ * - Сравнение форматирования строки температуры: snprintf("%5.1f"),
+ *   dtostrf() + snprintf() против Format
+ *
+ * Собирается только с флагом BENCHMARK (окружение [env:bench] в platformio.ini)
+ * и запускается из setup() до запуска остальной периферии.
+ * Результаты выводятся в Serial.
+ */
+class Benchmark {
+public:
+    /*
+     * Запуск всех замеров и печать отчета
+     */
+    static void run() {
+        uint8_t savedA = TCCR1A;
+        uint8_t savedB = TCCR1B;
+        TCCR1A = 0;
+        TCCR1B = _BV(CS10); // Нормальный режим, без предделителя
+
+        Serial.println(F("--- Benchmark (cycles) ---"));
+        benchNtc();
+        benchFormat();
+
+        TCCR1A = savedA;
+        TCCR1B = savedB;
+    }
+
+private:
+    static const uint8_t SWEEP_POINTS = 32; // Количество кодов АЦП в замере
+
+    static volatile float sinkFloat;   // Приемник результата, чтобы вызов не выбросил оптимизатор
+    static volatile int16_t sinkInt;
+
+    /*
+     * Печать строки отчета: название, минимум, среднее, максимум
+     */
+    static void report(const __FlashStringHelper* name, uint16_t minCycles,
+                       uint32_t sumCycles, uint16_t maxCycles) {
+        Serial.print(name);
+        Serial.print(F(" min="));
+        Serial.print(minCycles);
+        Serial.print(F(" avg="));
+        Serial.print(sumCycles / SWEEP_POINTS);
+        Serial.print(F(" max="));
+        Serial.println(maxCycles);
+    }
+
+    /*
+     * Пересчет кода АЦП в температуру обоими способами по всей шкале
+     */
+    static void benchNtc() {
+        GyverNTC ntc(A0, NTC_SERIES_R, NTC_BETA);
+        const uint16_t step = (1 << AdcSampler::RESULT_BITS) / SWEEP_POINTS;
+
+        uint16_t minFloat = 0xFFFF, maxFloat = 0, minTable = 0xFFFF, maxTable = 0;
+        uint32_t sumFloat = 0, sumTable = 0;
+
+        for (uint16_t code = step / 2; code < (1 << AdcSampler::RESULT_BITS); code += step) {
+            float analog = code * (1.0f / (1 << AdcSampler::OVERSAMPLE_BITS));
+            uint16_t t0, t1;
+
+            noInterrupts();
+            t0 = TCNT1;
+            sinkFloat = ntc.computeTemp(analog);
+            t1 = TCNT1;
+            interrupts();
+            uint16_t cycles = t1 - t0;
+            sumFloat += cycles;
+            if (cycles < minFloat) minFloat = cycles;
+            if (cycles > maxFloat) maxFloat = cycles;
+
+            noInterrupts();
+            t0 = TCNT1;
+            sinkInt = NtcLookup::convert(code);
+            t1 = TCNT1;
+            interrupts();
+            cycles = t1 - t0;
+            sumTable += cycles;
+            if (cycles < minTable) minTable = cycles;
+            if (cycles > maxTable) maxTable = cycles;
+        }
+
+        report(F("NTC GyverNTC:"), minFloat, sumFloat, maxFloat);
+        report(F("NTC table:   "), minTable, sumTable, maxTable);
+    }
+
+    /*
+     * Форматирование строки главного экрана "Temp: XX.X C" по диапазону температур
+     * Разницу во флеш-памяти показывает pio run: размер [env:nanoatmega328]
+     * против [env:size_printf], где Format выводит через snprintf и dtostrf
+     */
+    static void benchFormat() {
+        char line[Display::LINE_BUFFER];
+        uint16_t minPrintf = 0xFFFF, maxPrintf = 0, minDtostrf = 0xFFFF, maxDtostrf = 0;
+        uint16_t minFormat = 0xFFFF, maxFormat = 0;
+        uint32_t sumPrintf = 0, sumDtostrf = 0, sumFormat = 0;
+
+        for (uint8_t i = 0; i < SWEEP_POINTS; i++) {
+            int16_t centi = -3000 + i * 397; // -30.00 .. 93.07 °C
+            float temp = centi * 0.01f;
+            uint16_t t0, t1, cycles;
+
+            // Как было в Display: без printf_flt в avr-libc выводит "?"
+            noInterrupts();
+            t0 = TCNT1;
+            snprintf(line, sizeof(line), "Temp: %5.1f C", temp);
+            t1 = TCNT1;
+            interrupts();
+            cycles = t1 - t0;
+            sumPrintf += cycles;
+            if (cycles < minPrintf) minPrintf = cycles;
+            if (cycles > maxPrintf) maxPrintf = cycles;
+
+            // Как было в ButtonMenuHandler::showEditValue()
+            noInterrupts();
+            t0 = TCNT1;
+            char value[10];
+            dtostrf(temp, 5, 1, value);
+            snprintf(line, sizeof(line), "Temp: %s C", value);
+            t1 = TCNT1;
+            interrupts();
+            cycles = t1 - t0;
+            sumDtostrf += cycles;
+            if (cycles < minDtostrf) minDtostrf = cycles;
+            if (cycles > maxDtostrf) maxDtostrf = cycles;
+
+            noInterrupts();
+            t0 = TCNT1;
+            char* p = Format::text(line, "Temp: ");
+            p = Format::tempCenti(p, centi, 5);
+            Format::text(p, " C");
+            t1 = TCNT1;
+            interrupts();
+            cycles = t1 - t0;
+            sumFormat += cycles;
+            if (cycles < minFormat) minFormat = cycles;
+            if (cycles > maxFormat) maxFormat = cycles;
+        }
+
+        report(F("Fmt snprintf:"), minPrintf, sumPrintf, maxPrintf);
+        report(F("Fmt dtostrf: "), minDtostrf, sumDtostrf, maxDtostrf);
+        report(F("Fmt Format:  "), minFormat, sumFormat, maxFormat);
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    Benchmark() = delete;
+};
+
+volatile float Benchmark::sinkFloat = 0.0f;
+volatile int16_t Benchmark::sinkInt = 0;
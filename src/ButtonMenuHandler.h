@@ -1,10 +1,12 @@
 #pragma once
-#include <GyverButton.h>
 #include "Display.h"
+#include "InputEvent.h"
+#include "ButtonScanner.h"
 #include "CoolerController.h"
 #include "MixerController.h"
 #include "WashingController.h"
-#include "TemperatureSensor.h"
+#include "SensorArray.h"
+#include "MemoryMonitor.h"
 
 // Перечисления событий для обработки кнопок
 enum MenuEvent {
@@ -24,109 +26,299 @@ enum MenuState {
     STATE_COOLER_MENU,
     STATE_MIXER_MENU,
     STATE_WASHER_MENU,
+    STATE_RECIPE_MENU,   // Шаги пользовательского рецепта
     STATE_TEST_MENU,
-    STATE_EDIT_VALUE
+    STATE_EDIT_VALUE,
+    STATE_RESUME_PROMPT, // Вопрос о продолжении прерванной мойки
+    STATE_DIAGNOSTICS    // Диагностика: свободная RAM
 };
 
-// Структура пункта меню
+// Тип редактируемого значения (определяет формат вывода)
+enum MenuValueType : uint8_t {
+    VALUE_U8,   // Целое 0..255
+    VALUE_U16,  // Целое без знака
+    VALUE_TEMP,     // Температура в десятых долях градуса
+    VALUE_OPTIONAL, // Целое без знака, 0 - "off"
+    VALUE_OUTPUTS,  // Выходы мойки (биты OUT_WASH_GROUP, сдвинутые к младшему)
+    VALUE_RECIPE,   // Рецепт (RecipeId), выводится название
+    VALUE_STEP_NAME // Название шага (StepName)
+};
+
+// Редактируемые значения (индекс в таблице ButtonMenuHandler::values)
+enum MenuValueId : uint8_t {
+    VALUE_COOLER_TARGET,
+    VALUE_COOLER_HYSTERESIS,
+    VALUE_COOLER_MIN_INTERVAL,
+    VALUE_MIXER_MODE,
+    VALUE_MIXER_WORK_TIME,
+    VALUE_MIXER_IDLE_TIME,
+    VALUE_RECIPE_ID,
+    VALUE_STEP_COUNT,
+    VALUE_STEP_INDEX,
+    VALUE_STEP_NAME_ID,
+    VALUE_STEP_TIME,
+    VALUE_STEP_OUTPUTS,
+    VALUE_STEP_MIN_TEMP,
+    VALUE_STEP_TIMEOUT,
+    VALUE_COUNT,
+    VALUE_NONE = 0xFF // Пункт без значения (переход в подменю или действие)
+};
+
+class ButtonMenuHandler;
+
+/*
+ * Описание редактируемого значения (PROGMEM)
+ * Значение при редактировании - int16_t в единицах вывода (для температуры - десятые °C);
+ * get/set переводят его в поле настроек нужного типа
+ */
+struct MenuValue {
+    uint8_t type;     // MenuValueType
+    int16_t min;
+    int16_t max;
+    int16_t step;
+    const char* unit; // Единица измерения (PROGMEM)
+    int16_t (*get)(ButtonMenuHandler&);
+    void (*set)(ButtonMenuHandler&, int16_t);
+};
+
+/*
+ * Пункт меню (PROGMEM)
+ */
 struct MenuItem {
-    const char* text;
-    MenuState nextState;
-    float* value; // Указатель на значение, которое редактируется
-    float min;
-    float max;
-    float step;
-    const char* unit;
+    const char* text;  // Текст пункта (PROGMEM)
+    uint8_t nextState; // Состояние при выборе (MenuState)
+    uint8_t value;     // Редактируемое значение (MenuValueId) или VALUE_NONE
 };
 
+// Тексты пунктов меню в PROGMEM
+const char menuTextCooler[] PROGMEM = "Cooler Settings";
+const char menuTextMixer[] PROGMEM = "Mixer Settings";
+const char menuTextWasher[] PROGMEM = "Washer Settings";
+const char menuTextTest[] PROGMEM = "Test Mechanisms";
+const char menuTextDiagnostics[] PROGMEM = "Diagnostics";
+const char menuTextTargetTemp[] PROGMEM = "Target Temp";
+const char menuTextHysteresis[] PROGMEM = "Hysteresis";
+const char menuTextMinInterval[] PROGMEM = "Min Interval";
+const char menuTextMode[] PROGMEM = "Mode";
+const char menuTextWorkTime[] PROGMEM = "Work Time";
+const char menuTextIdleTime[] PROGMEM = "Idle Time";
+const char menuTextRecipe[] PROGMEM = "Recipe";
+const char menuTextCustomRecipe[] PROGMEM = "Custom Recipe";
+const char menuTextStepCount[] PROGMEM = "Steps";
+const char menuTextStepIndex[] PROGMEM = "Edit Step";
+const char menuTextStepName[] PROGMEM = "Name";
+const char menuTextStepTime[] PROGMEM = "Time";
+const char menuTextStepOutputs[] PROGMEM = "Outputs";
+const char menuTextStepMinTemp[] PROGMEM = "Min Temp";
+const char menuTextStepTimeout[] PROGMEM = "Timeout";
+const char menuTextCompressor[] PROGMEM = "Compressor";
+const char menuTextMixerTest[] PROGMEM = "Mixer";
+const char menuTextWashPump[] PROGMEM = "Wash Pump";
+const char menuTextDrainValve[] PROGMEM = "Drain Valve";
+const char menuTextColdWater[] PROGMEM = "Cold Water";
+const char menuTextHotWater[] PROGMEM = "Hot Water";
+const char menuTextAlkaliPump[] PROGMEM = "Alkali Pump";
+const char menuTextAcidPump[] PROGMEM = "Acid Pump";
+const char menuUnitNone[] PROGMEM = "";
+const char menuUnitCelsius[] PROGMEM = "C";
+const char menuUnitSeconds[] PROGMEM = "s";
+const char menuValueOff[] PROGMEM = "off";
+// Буквы выходов мойки в порядке битов: слив, холодная, горячая вода,
+// моющий насос, щелочь, кислота
+const char menuOutputLetters[] PROGMEM = "DCHPAK";
+
+/*
+ * Меню системы
+ * Реализует:
+ * - Дерево меню в PROGMEM: пункты и описания значений не занимают RAM
+ * - Типизированное редактирование: u8, u16 и температура в фиксированной точке;
+ *   поля настроек читаются и пишутся через функции доступа своего типа
+ * - Выбор рецепта мойки и редактирование шагов пользовательского рецепта
+ * - Тестовое меню: ручное включение механизмов
+ * - Вопрос о продолжении прерванной мойки
+ * - Экран диагностики памяти (MemoryMonitor)
+ */
 class ButtonMenuHandler {
 private:
-    GButton btnUp, btnDown, btnSet, btnEsc;
     Display& display;
     CoolerController& cooler;
     MixerController& mixer;
     WashingController& washer;
-    TemperatureSensor& tempSensor; // Добавлен объект для датчика температуры
+    SensorArray& sensors; // Группа датчиков температуры
 
     MenuState currentState = STATE_MAIN_SCREEN;
     MenuState previousState = STATE_MAIN_SCREEN; // Для возврата на предыдущий уровень
     uint8_t currentItem = 0;
-    float editValue = 0.0f; // Текущее редактируемое значение
+    int16_t editValue = 0; // Текущее редактируемое значение (в единицах вывода)
 
-    const MenuItem* currentMenu = nullptr; // Указатель на текущий активный массив меню
+    const MenuItem* currentMenu = nullptr; // Текущий активный массив меню (PROGMEM)
     uint8_t menuSize = 0; // Размер текущего меню
+    uint8_t testStates = 0; // Состояния механизмов в тестовом меню (бит на пункт)
+    uint8_t editId = VALUE_NONE;     // Редактируемое значение (MenuValueId)
+    uint8_t editStep = 0;            // Редактируемый шаг пользовательского рецепта (с нуля)
+    const char* editText = nullptr;  // Название редактируемого пункта (PROGMEM)
 
-    // Пункты меню теперь являются членами класса, а не статическими,
-    // что позволяет им ссылаться на экземпляры контроллеров.
-    const MenuItem mainMenu[4];
-    const MenuItem coolerMenu[3];
-    const MenuItem mixerMenu[3];
-    const MenuItem washerMenu[5];
-    const MenuItem testMenu[8];
+    // Дерево меню во флеш-памяти
+    static const MenuItem mainMenu[5] PROGMEM;
+    static const MenuItem coolerMenu[3] PROGMEM;
+    static const MenuItem mixerMenu[3] PROGMEM;
+    static const MenuItem washerMenu[2] PROGMEM;
+    static const MenuItem recipeMenu[7] PROGMEM;
+    static const MenuItem testMenu[8] PROGMEM;
+    static const MenuValue values[VALUE_COUNT] PROGMEM;
 
     // Таймер для автоматического возврата на главный экран
     unsigned long returnTimer = 0;
     const unsigned long RETURN_TIMEOUT = 30000; // 30 секунд бездействия
 
+    // Временное сообщение ("Saved!", "ON"/"OFF") показывается без delay(),
+    // чтобы меню не останавливало главный цикл и регулирование
+    unsigned long messageTime = 0;
+    bool messageActive = false;
+    const unsigned long MESSAGE_TIME = 1000; // Время показа сообщения (мс)
+
     /*
-     * Опрашивает кнопки и возвращает соответствующее событие
+     * Преобразует событие кнопки из ButtonScanner в событие меню
      */
-    MenuEvent getEvent() {
-        if (btnUp.isClick()) return EVENT_UP;
-        if (btnDown.isClick()) return EVENT_DOWN;
-        if (btnSet.isClick()) return EVENT_SELECT;
-        if (btnEsc.isClick()) return EVENT_BACK;
-        if (btnUp.isHold()) return EVENT_HOLD_UP; // Удержание кнопки для ускоренной прокрутки
-        if (btnDown.isHold()) return EVENT_HOLD_DOWN; // Удержание кнопки для ускоренной прокрутки
+    static MenuEvent toMenuEvent(const InputEvent& input) {
+        if (input.type == INPUT_BUTTON_CLICK) {
+            switch (input.code) {
+                case BUTTON_UP: return EVENT_UP;
+                case BUTTON_DOWN: return EVENT_DOWN;
+                case BUTTON_SET: return EVENT_SELECT;
+                case BUTTON_ESC: return EVENT_BACK;
+                default: return EVENT_NONE;
+            }
+        }
+        // Удержание и автоповтор для ускоренной прокрутки
+        if (input.code == BUTTON_UP) return EVENT_HOLD_UP;
+        if (input.code == BUTTON_DOWN) return EVENT_HOLD_DOWN;
         return EVENT_NONE;
     }
 
+    /*
+     * Функции доступа к полям настроек (вызываются через MenuValue)
+     * Температура хранится в float (°C), в меню - в десятых долях градуса
+     */
+    static int16_t toTenths(float value) {
+        return (int16_t)(value * 10.0f + (value < 0 ? -0.5f : 0.5f));
+    }
+    static int16_t getTargetTemp(ButtonMenuHandler& m) { return toTenths(m.cooler.getSettings().targetTemp); }
+    static void setTargetTemp(ButtonMenuHandler& m, int16_t v) { m.cooler.getSettings().targetTemp = v / 10.0f; }
+    static int16_t getHysteresis(ButtonMenuHandler& m) { return toTenths(m.cooler.getSettings().hysteresis); }
+    static void setHysteresis(ButtonMenuHandler& m, int16_t v) { m.cooler.getSettings().hysteresis = v / 10.0f; }
+    static int16_t getMinInterval(ButtonMenuHandler& m) { return m.cooler.getSettings().minInterval; }
+    static void setMinInterval(ButtonMenuHandler& m, int16_t v) { m.cooler.getSettings().minInterval = v; }
+    static int16_t getMixerMode(ButtonMenuHandler& m) { return m.mixer.getSettings().mode; }
+    static void setMixerMode(ButtonMenuHandler& m, int16_t v) { m.mixer.getSettings().mode = v; }
+    static int16_t getWorkTime(ButtonMenuHandler& m) { return m.mixer.getSettings().workTime; }
+    static void setWorkTime(ButtonMenuHandler& m, int16_t v) { m.mixer.getSettings().workTime = v; }
+    static int16_t getIdleTime(ButtonMenuHandler& m) { return m.mixer.getSettings().idleTime; }
+    static void setIdleTime(ButtonMenuHandler& m, int16_t v) { m.mixer.getSettings().idleTime = v; }
+
+    static int16_t getRecipe(ButtonMenuHandler& m) { return m.washer.getSettings().recipe; }
+    static void setRecipe(ButtonMenuHandler& m, int16_t v) { m.washer.getSettings().recipe = v; }
+    static int16_t getStepCount(ButtonMenuHandler& m) { return m.washer.getSettings().customStepCount; }
+    static void setStepCount(ButtonMenuHandler& m, int16_t v) { m.washer.getSettings().customStepCount = v; }
+    // Номер шага в меню - с единицы
+    static int16_t getStepIndex(ButtonMenuHandler& m) { return m.editStep + 1; }
+    static void setStepIndex(ButtonMenuHandler& m, int16_t v) { m.editStep = v - 1; }
+
+    RecipeStep& editedStep() {
+        return washer.getSettings().customSteps[editStep];
+    }
+    static int16_t getStepName(ButtonMenuHandler& m) {
+        uint8_t name = m.editedStep().name;
+        return (name < STEP_NAME_COUNT) ? name : (uint8_t)STEP_IDLE;
+    }
+    static void setStepName(ButtonMenuHandler& m, int16_t v) { m.editedStep().name = v; }
+    static int16_t getStepTime(ButtonMenuHandler& m) { return m.editedStep().duration; }
+    static void setStepTime(ButtonMenuHandler& m, int16_t v) { m.editedStep().duration = v; }
+    static int16_t getStepTimeout(ButtonMenuHandler& m) { return m.editedStep().timeout; }
+    static void setStepTimeout(ButtonMenuHandler& m, int16_t v) { m.editedStep().timeout = v; }
+
+    // Выходы мойки - старшие 6 бит, в меню они сдвинуты к младшему
+    static const uint8_t OUTPUTS_SHIFT = 2;
+    static_assert(OUT_WASH_GROUP == (0x3F << OUTPUTS_SHIFT), "ButtonMenuHandler: wash outputs must be the top 6 bits");
+    static int16_t getStepOutputs(ButtonMenuHandler& m) { return m.editedStep().outputs >> OUTPUTS_SHIFT; }
+    static void setStepOutputs(ButtonMenuHandler& m, int16_t v) { m.editedStep().outputs = v << OUTPUTS_SHIFT; }
+
+    // Температура шага в меню: 0 - без условия (RECIPE_NO_TEMP)
+    static int16_t getStepMinTemp(ButtonMenuHandler& m) {
+        int8_t t = m.editedStep().minTemp;
+        return (t == RECIPE_NO_TEMP || t < 0) ? 0 : t;
+    }
+    static void setStepMinTemp(ButtonMenuHandler& m, int16_t v) {
+        RecipeStep& step = m.editedStep();
+        step.minTemp = (v == 0) ? RECIPE_NO_TEMP : v;
+        // Ожидание температуры без таймаута недопустимо (см. RecipeCheck::stepValid)
+        if (step.minTemp != RECIPE_NO_TEMP && step.timeout == 0) step.timeout = RECIPE_DEFAULT_TIMEOUT;
+    }
+
+    /*
+     * Открывает меню из PROGMEM
+     */
+    template<uint8_t N>
+    void openMenu(const MenuItem (&items)[N]) {
+        currentMenu = items;
+        menuSize = N;
+        showMenu();
+    }
+
+    /*
+     * Чтение пункта текущего меню и описания его значения из PROGMEM
+     */
+    MenuItem readItem(uint8_t index) const {
+        MenuItem item;
+        memcpy_P(&item, &currentMenu[index], sizeof(item));
+        return item;
+    }
+
+    static MenuValue readValue(uint8_t id) {
+        MenuValue value;
+        memcpy_P(&value, &values[id], sizeof(value));
+        return value;
+    }
+
     /*
      * Переводит систему в новое состояние меню
      */
     void goToState(MenuState newState) {
+        // В тестовом меню регулирование компрессора и миксера приостановлено,
+        // иначе их задачи отменили бы ручное включение на следующем периоде
+        bool testing = (newState == STATE_TEST_MENU);
+        if (testing != (currentState == STATE_TEST_MENU)) {
+            cooler.setManual(testing);
+            mixer.setManual(testing);
+            if (testing) {
+                testStates = (testStates & ~0x03) | (cooler.isRunning() ? 0x01 : 0) |
+                             (mixer.isActive() ? 0x02 : 0);
+            }
+        }
+
         previousState = currentState; // Сохраняем текущее состояние как предыдущее
         currentState = newState;
         currentItem = 0; // При входе в новое меню всегда начинаем с первого элемента
 
         switch (currentState) {
-            case STATE_MAIN_MENU:
-                currentMenu = mainMenu;
-                menuSize = 4;
-                showMenu();
-                break;
-            case STATE_COOLER_MENU:
-                currentMenu = coolerMenu;
-                menuSize = 3;
-                showMenu();
-                break;
-            case STATE_MIXER_MENU:
-                currentMenu = mixerMenu;
-                menuSize = 3;
-                showMenu();
-                break;
-            case STATE_WASHER_MENU:
-                currentMenu = washerMenu;
-                menuSize = 5;
-                showMenu();
-                break;
-            case STATE_TEST_MENU:
-                currentMenu = testMenu;
-                menuSize = 8;
-                showMenu();
-                break;
+            case STATE_MAIN_MENU: openMenu(mainMenu); break;
+            case STATE_COOLER_MENU: openMenu(coolerMenu); break;
+            case STATE_MIXER_MENU: openMenu(mixerMenu); break;
+            case STATE_WASHER_MENU: openMenu(washerMenu); break;
+            case STATE_RECIPE_MENU: openMenu(recipeMenu); break;
+            case STATE_TEST_MENU: openMenu(testMenu); break;
             case STATE_EDIT_VALUE:
-                // При входе в режим редактирования, загружаем текущее значение
-                if (currentMenu[currentItem].value != nullptr) {
-                    editValue = *currentMenu[currentItem].value;
-                } else {
-                    editValue = 0.0f; // Дефолтное значение, если указатель не задан
-                }
+                // При входе в режим редактирования загружаем текущее значение
+                editValue = (editId < VALUE_COUNT) ? readValue(editId).get(*this) : 0;
                 showEditValue();
                 break;
             case STATE_MAIN_SCREEN:
                 showMainScreen(); // Обновляем главный экран
                 break;
+            case STATE_RESUME_PROMPT:
+            case STATE_DIAGNOSTICS:
+                redraw();
+                break;
             default:
                 // Если состояние не определено, возвращаемся на главный экран
                 goToState(STATE_MAIN_SCREEN);
@@ -134,26 +326,77 @@ private:
         }
     }
 
+    /*
+     * Показывает временное сообщение; по истечении MESSAGE_TIME
+     * экран текущего состояния перерисовывается в update()
+     */
+    void showTimedMessage(const char* message) {
+        display.showMessage(message);
+        messageTime = millis();
+        messageActive = true;
+    }
+
+    /*
+     * Перерисовка экрана текущего состояния
+     */
+    void redraw() {
+        switch (currentState) {
+            case STATE_MAIN_SCREEN: showMainScreen(); break;
+            case STATE_EDIT_VALUE: showEditValue(); break;
+            case STATE_RESUME_PROMPT:
+                display.showPrompt("Resume wash?", "SET=Yes ESC=Rins");
+                break;
+            case STATE_DIAGNOSTICS:
+                display.showMemoryScreen(MemoryMonitor::getMinFree(), MemoryMonitor::getFreeNow(),
+                                         MemoryMonitor::getHeapUsed());
+                break;
+            default: showMenu(); break;
+        }
+    }
+
     /*
      * Отображает текущее меню на дисплее
      */
     void showMenu() {
-        char buf[17];
-        snprintf(buf, sizeof(buf), "%s", currentMenu[currentItem].text);
-        display.showMenuScreen(buf, currentItem + 1, menuSize);
+        char text[Display::LINE_BUFFER];
+        Format::textP(text, readItem(currentItem).text);
+        display.showMenuScreen(text, currentItem + 1, menuSize);
     }
 
     /*
      * Отображает экран редактирования значения
      */
     void showEditValue() {
-        char buf[17];
-        char valStr[10];
-        dtostrf(editValue, 4, 1, valStr); // Форматируем float в строку
-        snprintf(buf, sizeof(buf), "%s: %s %s",
-                 currentMenu[currentItem].text,
-                 valStr,
-                 currentMenu[currentItem].unit);
+        if (editId >= VALUE_COUNT) return;
+        MenuValue value = readValue(editId);
+        char buf[Display::LINE_BUFFER];
+        char* p = Format::textP(buf, editText);
+        // Названия не помещаются в одну строку с пунктом: выводятся второй строкой
+        if (value.type == VALUE_RECIPE || value.type == VALUE_STEP_NAME) {
+            char name[Display::LINE_BUFFER];
+            const char* text = (value.type == VALUE_RECIPE)
+                ? (const char*)pgm_read_ptr(&builtinRecipes[editValue].name)
+                : (const char*)pgm_read_ptr(&stepNames[editValue]);
+            Format::textP(name, text);
+            display.showPrompt(buf, name);
+            return;
+        }
+        p = Format::text(p, ": ");
+        if (value.type == VALUE_TEMP) {
+            p = Format::fixed(p, editValue, 1, 4);
+        } else if (value.type == VALUE_OPTIONAL && editValue == 0) {
+            Format::textP(p, menuValueOff);
+            display.showMessage(buf);
+            return;
+        } else if (value.type == VALUE_OUTPUTS) {
+            for (uint8_t i = 0; i < 6; i++) {
+                p = Format::character(p, (editValue & (1 << i)) ? pgm_read_byte(&menuOutputLetters[i]) : '-');
+            }
+        } else {
+            p = Format::unsignedInt(p, (uint16_t)editValue, 3);
+        }
+        p = Format::character(p, ' ');
+        Format::textP(p, value.unit);
         display.showMessage(buf);
     }
 
@@ -161,13 +404,8 @@ private:
      * Выполняет действие для тестового меню
      */
     void handleTestAction(uint8_t item) {
-        // Здесь можно добавить логику включения/выключения для тестовых элементов
-        // Пример:
-        bool state = false; // Состояние по умолчанию - выключено
-        if (currentMenu[item].value != nullptr) {
-            state = !(*currentMenu[item].value); // Переключаем состояние
-            *currentMenu[item].value = state;
-        }
+        testStates ^= 1 << item; // Переключаем состояние
+        bool state = (testStates >> item) & 1;
 
         switch (item) {
             case 0: cooler.setCompressorState(state); break;
@@ -180,24 +418,35 @@ private:
             case 7: washer.setAcidPump(state); break;
         }
         
-        display.showMessage(state ? "ON" : "OFF"); // Показываем состояние
-        delay(1000);
-        showMenu(); // Возвращаемся в тестовое меню
+        showTimedMessage(state ? "ON" : "OFF"); // Показываем состояние, затем тестовое меню
+    }
+
+    /*
+     * Шаг редактируемого значения вверх или вниз в пределах min..max
+     */
+    void stepEditValue(bool up) {
+        if (editId >= VALUE_COUNT) return;
+        MenuValue value = readValue(editId);
+        int16_t next = up ? editValue + value.step : editValue - value.step;
+        editValue = constrain(next, value.min, value.max);
+        showEditValue();
     }
 
     /*
      * Сохраняет отредактированное значение в соответствующий контроллер
      */
     void saveCurrentValue() {
-        if (currentMenu[currentItem].value != nullptr) {
-            *currentMenu[currentItem].value = editValue; // Сохраняем значение
+        if (editId < VALUE_COUNT) {
+            readValue(editId).set(*this, editValue); // Сохраняем значение
         }
+        if (editId == VALUE_STEP_INDEX) return; // Выбор шага - навигация, настройки не меняются
         
         // Сохраняем настройки в соответствующий контроллер
         switch (previousState) {
             case STATE_COOLER_MENU: cooler.saveSettings(); break;
             case STATE_MIXER_MENU: mixer.saveSettings(); break;
-            case STATE_WASHER_MENU: washer.saveSettings(); break;
+            case STATE_WASHER_MENU:
+            case STATE_RECIPE_MENU: washer.saveSettings(); break;
             default: break;
         }
     }
@@ -206,74 +455,52 @@ public:
     /*
      * Конструктор класса
      */
-    ButtonMenuHandler(uint8_t upPin, uint8_t downPin, uint8_t setPin, uint8_t escPin,
-                      Display& displayRef, CoolerController& coolerRef,
+    ButtonMenuHandler(Display& displayRef, CoolerController& coolerRef,
                       MixerController& mixerRef, WashingController& washerRef,
-                      TemperatureSensor& tempSensorRef)
-        : btnUp(upPin), btnDown(downPin), btnSet(setPin), btnEsc(escPin),
-          display(displayRef), cooler(coolerRef), mixer(mixerRef), washer(washerRef),
-          tempSensor(tempSensorRef),
-          // Инициализация массивов меню с использованием ссылок на параметры контроллеров
-          mainMenu{
-              {"Cooler Settings", STATE_COOLER_MENU, nullptr, 0, 0, 0, ""},
-              {"Mixer Settings", STATE_MIXER_MENU, nullptr, 0, 0, 0, ""},
-              {"Washer Settings", STATE_WASHER_MENU, nullptr, 0, 0, 0, ""},
-              {"Test Mechanisms", STATE_TEST_MENU, nullptr, 0, 0, 0, ""}
-          },
-          coolerMenu{
-              {"Target Temp", STATE_EDIT_VALUE, &cooler.getSettings().targetTemp, -10, 30, 0.5, "C"},
-              {"Hysteresis", STATE_EDIT_VALUE, &cooler.getSettings().hysteresis, 0.5, 5, 0.1, "C"},
-              {"Min Interval", STATE_EDIT_VALUE, (float*)&cooler.getSettings().minInterval, 10, 600, 10, "s"} // Приведение типа
-          },
-          mixerMenu{
-              {"Mode", STATE_EDIT_VALUE, (float*)&mixer.getSettings().mode, 0, 2, 1, ""}, // Приведение типа
-              {"Work Time", STATE_EDIT_VALUE, (float*)&mixer.getSettings().workTime, 10, 600, 10, "s"}, // Приведение типа
-              {"Idle Time", STATE_EDIT_VALUE, (float*)&mixer.getSettings().idleTime, 10, 600, 10, "s"} // Приведение типа
-          },
-          washerMenu{
-              {"Stage 1 Time", STATE_EDIT_VALUE, (float*)&washer.getSettings().stageTimes[0], 5, 300, 5, "s"},
-              {"Stage 2 Time", STATE_EDIT_VALUE, (float*)&washer.getSettings().stageTimes[1], 5, 300, 5, "s"},
-              {"Stage 3 Time", STATE_EDIT_VALUE, (float*)&washer.getSettings().stageTimes[2], 5, 300, 5, "s"},
-              {"Stage 4 Time", STATE_EDIT_VALUE, (float*)&washer.getSettings().stageTimes[3], 5, 300, 5, "s"},
-              {"Stage 5 Time", STATE_EDIT_VALUE, (float*)&washer.getSettings().stageTimes[4], 5, 300, 5, "s"}
-          },
-          testMenu{
-              // Для тестового меню, value теперь указывает на временные состояния для переключения
-              {"Compressor", STATE_TEST_MENU, new float(false), 0, 1, 1, ""}, // Временные состояния для теста
-              {"Mixer", STATE_TEST_MENU, new float(false), 0, 1, 1, ""},
-              {"Wash Pump", STATE_TEST_MENU, new float(false), 0, 1, 1, ""},
-              {"Drain Valve", STATE_TEST_MENU, new float(false), 0, 1, 1, ""},
-              {"Cold Water", STATE_TEST_MENU, new float(false), 0, 1, 1, ""},
-              {"Hot Water", STATE_TEST_MENU, new float(false), 0, 1, 1, ""},
-              {"Alkali Pump", STATE_TEST_MENU, new float(false), 0, 1, 1, ""},
-              {"Acid Pump", STATE_TEST_MENU, new float(false), 0, 1, 1, ""}
-          }
-    {
-        btnUp.setTickMode(AUTO);
-        btnDown.setTickMode(AUTO);
-        btnSet.setTickMode(AUTO);
-        btnEsc.setTickMode(AUTO);
-        
-    }
+                      SensorArray& sensorsRef)
+        : display(displayRef), cooler(coolerRef), mixer(mixerRef), washer(washerRef),
+          sensors(sensorsRef)
+    {}
 
-    // Деструктор для освобождения памяти, выделенной для testMenu
-    ~ButtonMenuHandler() {
-        for (uint8_t i = 0; i < 8; ++i) {
-            delete testMenu[i].value;
-        }
+    /*
+     * Обработка события кнопки меню (из очереди событий ввода)
+     */
+    void handleInput(const InputEvent& input) {
+        process(toMenuEvent(input));
     }
 
     /*
-     * Основной метод обновления состояния меню
+     * Периодическое обновление: временные сообщения и возврат по бездействию
      */
     void update() {
-        MenuEvent event = getEvent();
+        process(EVENT_NONE);
+    }
+
+    /*
+     * Основной метод обработки состояния меню
+     */
+    void process(MenuEvent event) {
+        // Пока показано временное сообщение, события кнопок игнорируются
+        if (messageActive) {
+            if (millis() - messageTime < MESSAGE_TIME) return;
+            messageActive = false;
+            returnTimer = millis();
+            redraw();
+            return;
+        }
         
         // Сбрасываем таймер активности при любом событии кнопки
         if (event != EVENT_NONE) {
             returnTimer = millis();
         }
 
+        // Без ответа на вопрос о прерванной мойке линия промывается от химии
+        if (currentState == STATE_RESUME_PROMPT && (millis() - returnTimer > RETURN_TIMEOUT)) {
+            washer.startRinseOut();
+            goToState(STATE_MAIN_SCREEN);
+            return;
+        }
+
         // Автоматический возврат на главный экран при бездействии
         if (currentState != STATE_MAIN_SCREEN && (millis() - returnTimer > RETURN_TIMEOUT)) {
             goToState(STATE_MAIN_SCREEN);
@@ -283,7 +510,7 @@ public:
         switch (currentState) {
             case STATE_MAIN_SCREEN:
                 // Переход в главное меню по нажатию "SET"
-                if (btnSet.isClick()) {
+                if (event == EVENT_SELECT) {
                     goToState(STATE_MAIN_MENU);
                 }
                 break;
@@ -292,6 +519,7 @@ public:
             case STATE_COOLER_MENU:
             case STATE_MIXER_MENU:
             case STATE_WASHER_MENU:
+            case STATE_RECIPE_MENU:
             case STATE_TEST_MENU:
                 if (event == EVENT_UP && currentItem > 0) {
                     currentItem--;
@@ -303,12 +531,17 @@ public:
                     if (currentState == STATE_TEST_MENU) {
                         handleTestAction(currentItem);
                     } else {
-                        goToState(currentMenu[currentItem].nextState);
+                        MenuItem item = readItem(currentItem);
+                        editId = item.value;
+                        editText = item.text;
+                        goToState((MenuState)item.nextState);
                     }
                 } else if (event == EVENT_BACK) {
                     // Возврат на предыдущий уровень (MAIN_SCREEN для MAIN_MENU)
                     if (currentState == STATE_MAIN_MENU) {
                          goToState(STATE_MAIN_SCREEN);
+                    } else if (currentState == STATE_RECIPE_MENU) {
+                        goToState(STATE_WASHER_MENU);
                     } else {
                         // Для подменю (Cooler, Mixer, Washer, Test) возврат в MAIN_MENU
                         goToState(STATE_MAIN_MENU);
@@ -318,27 +551,50 @@ public:
 
             case STATE_EDIT_VALUE:
                 if (event == EVENT_UP || event == EVENT_HOLD_UP) {
-                    editValue = constrain(editValue + currentMenu[currentItem].step,
-                                         currentMenu[currentItem].min,
-                                         currentMenu[currentItem].max);
-                    showEditValue();
+                    stepEditValue(true);
                 } else if (event == EVENT_DOWN || event == EVENT_HOLD_DOWN) {
-                    editValue = constrain(editValue - currentMenu[currentItem].step,
-                                         currentMenu[currentItem].min,
-                                         currentMenu[currentItem].max);
-                    showEditValue();
+                    stepEditValue(false);
                 } else if (event == EVENT_SELECT) {
                     saveCurrentValue();
-                    display.showMessage("Saved!");
-                    delay(1000);
                     goToState(previousState); // Возвращаемся на предыдущий уровень меню
+                    showTimedMessage("Saved!");
                 } else if (event == EVENT_BACK) {
                     goToState(previousState); // Отмена редактирования и возврат
                 }
                 break;
+
+            case STATE_RESUME_PROMPT:
+                if (event == EVENT_SELECT) {
+                    if (!washer.resumeInterrupted()) {
+                        washer.startRinseOut(); // Шаг из журнала больше не существует
+                    }
+                    goToState(STATE_MAIN_SCREEN);
+                } else if (event == EVENT_BACK) {
+                    washer.startRinseOut();
+                    goToState(STATE_MAIN_SCREEN);
+                }
+                break;
+
+            case STATE_DIAGNOSTICS:
+                // Просмотр памяти занимает время, поэтому обновление - по кнопке
+                if (event == EVENT_BACK) {
+                    goToState(STATE_MAIN_MENU);
+                } else if (event != EVENT_NONE) {
+                    redraw();
+                }
+                break;
         }
     }
 
+    /*
+     * Показывает вопрос о продолжении мойки, прерванной сбросом
+     * SET - продолжить с сохраненного шага, ESC или бездействие - вымывание химии
+     */
+    void promptResume() {
+        returnTimer = millis();
+        goToState(STATE_RESUME_PROMPT);
+    }
+
     /*
      * Проверяет, активно ли меню (не главный экран)
      */
@@ -350,6 +606,75 @@ public:
      * Обновляет главный экран (вызывается из loop, когда меню не активно)
      */
     void showMainScreen() {
-      display.showMainScreen(tempSensor.getTemp(), mixer.isActive(), cooler.isRunning());
+      display.showMainScreen(cooler.getControlTempCenti(), cooler.isControlSensorOK(),
+                             mixer.isActive(), cooler.isRunning());
     }
 };
+
+// Дерево меню
+const MenuItem ButtonMenuHandler::mainMenu[5] PROGMEM = {
+    {menuTextCooler,      STATE_COOLER_MENU, VALUE_NONE},
+    {menuTextMixer,       STATE_MIXER_MENU,  VALUE_NONE},
+    {menuTextWasher,      STATE_WASHER_MENU, VALUE_NONE},
+    {menuTextTest,        STATE_TEST_MENU,   VALUE_NONE},
+    {menuTextDiagnostics, STATE_DIAGNOSTICS, VALUE_NONE}
+};
+
+const MenuItem ButtonMenuHandler::coolerMenu[3] PROGMEM = {
+    {menuTextTargetTemp,  STATE_EDIT_VALUE, VALUE_COOLER_TARGET},
+    {menuTextHysteresis,  STATE_EDIT_VALUE, VALUE_COOLER_HYSTERESIS},
+    {menuTextMinInterval, STATE_EDIT_VALUE, VALUE_COOLER_MIN_INTERVAL}
+};
+
+const MenuItem ButtonMenuHandler::mixerMenu[3] PROGMEM = {
+    {menuTextMode,     STATE_EDIT_VALUE, VALUE_MIXER_MODE},
+    {menuTextWorkTime, STATE_EDIT_VALUE, VALUE_MIXER_WORK_TIME},
+    {menuTextIdleTime, STATE_EDIT_VALUE, VALUE_MIXER_IDLE_TIME}
+};
+
+const MenuItem ButtonMenuHandler::washerMenu[2] PROGMEM = {
+    {menuTextRecipe,       STATE_EDIT_VALUE,  VALUE_RECIPE_ID},
+    {menuTextCustomRecipe, STATE_RECIPE_MENU, VALUE_NONE}
+};
+
+// Сначала выбирается шаг (Edit Step), остальные пункты меняют его поля
+const MenuItem ButtonMenuHandler::recipeMenu[7] PROGMEM = {
+    {menuTextStepCount,   STATE_EDIT_VALUE, VALUE_STEP_COUNT},
+    {menuTextStepIndex,   STATE_EDIT_VALUE, VALUE_STEP_INDEX},
+    {menuTextStepName,    STATE_EDIT_VALUE, VALUE_STEP_NAME_ID},
+    {menuTextStepTime,    STATE_EDIT_VALUE, VALUE_STEP_TIME},
+    {menuTextStepOutputs, STATE_EDIT_VALUE, VALUE_STEP_OUTPUTS},
+    {menuTextStepMinTemp, STATE_EDIT_VALUE, VALUE_STEP_MIN_TEMP},
+    {menuTextStepTimeout, STATE_EDIT_VALUE, VALUE_STEP_TIMEOUT}
+};
+
+// Порядок пунктов совпадает с номерами в handleTestAction()
+const MenuItem ButtonMenuHandler::testMenu[8] PROGMEM = {
+    {menuTextCompressor, STATE_TEST_MENU, VALUE_NONE},
+    {menuTextMixerTest,  STATE_TEST_MENU, VALUE_NONE},
+    {menuTextWashPump,   STATE_TEST_MENU, VALUE_NONE},
+    {menuTextDrainValve, STATE_TEST_MENU, VALUE_NONE},
+    {menuTextColdWater,  STATE_TEST_MENU, VALUE_NONE},
+    {menuTextHotWater,   STATE_TEST_MENU, VALUE_NONE},
+    {menuTextAlkaliPump, STATE_TEST_MENU, VALUE_NONE},
+    {menuTextAcidPump,   STATE_TEST_MENU, VALUE_NONE}
+};
+
+// Пределы и шаг - в единицах вывода (температура в десятых °C)
+const MenuValue ButtonMenuHandler::values[VALUE_COUNT] PROGMEM = {
+    {VALUE_TEMP, -100, 300, 5,  menuUnitCelsius, getTargetTemp,   setTargetTemp},
+    {VALUE_TEMP, 5,    50,  1,  menuUnitCelsius, getHysteresis,   setHysteresis},
+    {VALUE_U16,  10,   600, 10, menuUnitSeconds, getMinInterval,  setMinInterval},
+    {VALUE_U8,   0,    2,   1,  menuUnitNone,    getMixerMode,    setMixerMode},
+    {VALUE_U16,  10,   600, 10, menuUnitSeconds, getWorkTime,     setWorkTime},
+    {VALUE_U16,  10,   600, 10, menuUnitSeconds, getIdleTime,     setIdleTime},
+    // Служебный RECIPE_RINSE_OUT идет после RECIPE_CUSTOM и выбрать его нельзя
+    {VALUE_RECIPE,    0, RECIPE_CUSTOM,    1,  menuUnitNone,    getRecipe,      setRecipe},
+    {VALUE_U8,        0, RECIPE_MAX_STEPS, 1,  menuUnitNone,    getStepCount,   setStepCount},
+    {VALUE_U8,        1, RECIPE_MAX_STEPS, 1,  menuUnitNone,    getStepIndex,   setStepIndex},
+    {VALUE_STEP_NAME, STEP_COLD_RINSE, STEP_NAME_COUNT - 1, 1, menuUnitNone, getStepName, setStepName},
+    {VALUE_U16,       5, 600,              5,  menuUnitSeconds, getStepTime,    setStepTime},
+    {VALUE_OUTPUTS,   0, 0x3F,             1,  menuUnitNone,    getStepOutputs, setStepOutputs},
+    {VALUE_OPTIONAL,  0, 90,               1,  menuUnitCelsius, getStepMinTemp, setStepMinTemp},
+    {VALUE_U16,       30, 1800,            30, menuUnitSeconds, getStepTimeout, setStepTimeout}
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/interrupt.h> // Для ISR()
+#include "Pins.h"
+#include "InputEvent.h"
+#include "SystemTimer.h"
+
+/*
+ * Кнопки системы (номер канала сканера)
+ */
+enum ButtonId : uint8_t {
+    BUTTON_UP,
+    BUTTON_DOWN,
+    BUTTON_SET,
+    BUTTON_ESC,
+    BUTTON_WASH,
+    BUTTON_COUNT
+};
+
+/*
+ * Пины кнопок в порядке ButtonId (вычисляется на этапе компиляции)
+ */
+struct ButtonPinMap {
+    static constexpr uint8_t PINS[BUTTON_COUNT] = {
+        UP_BUTTON_PIN, DOWN_BUTTON_PIN, SET_BUTTON_PIN, ESC_BUTTON_PIN, WASH_BUTTON_PIN
+    };
+
+    static constexpr uint8_t portMask() {
+        uint8_t mask = 0;
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) mask |= 1 << PINS[i];
+        return mask;
+    }
+
+    // Все кнопки должны быть на PORTD (D0-D7), чтобы читаться одной операцией
+    static constexpr bool allOnPortD() {
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            if (PINS[i] >= 8) return false;
+        }
+        return true;
+    }
+};
+
+/*
+ * Сканер кнопок
+ * Реализует:
+ * - Чтение всех кнопок одной операцией чтения PIND
+ * - Запуск опроса по прерыванию изменения уровня (PCINT2): пока кнопки
+ *   отпущены и стабильны, опрос остановлен и не тратит время процессора
+ * - Подавление дребезга сразу для всех каналов вертикальными счетчиками:
+ *   состояние меняется после 4 одинаковых отсчетов подряд (16 мс)
+ * - События нажатия (click), удержания (hold) и автоповтора (repeat)
+ *   в очередь InputQueue; короткое нажатие не теряется, даже если
+ *   главный цикл в этот момент занят
+ *
+ * Отсчеты берутся по прерыванию Timer2 (CTC, 4 мс): tone() и ШИМ
+ * на пинах 3 и 11 недоступны.
+ */
+class ButtonScanner {
+public:
+    static const uint8_t SAMPLE_MS = 4;                  // Период отсчетов
+    static const uint8_t HOLD_SAMPLES = 500 / SAMPLE_MS; // Удержание: 500 мс
+    static const uint8_t REPEAT_SAMPLES = 150 / SAMPLE_MS; // Автоповтор: каждые 150 мс
+
+private:
+    static constexpr uint8_t MASK = ButtonPinMap::portMask(); // Биты кнопок в PORTD
+    static_assert(ButtonPinMap::allOnPortD(), "ButtonScanner: all buttons must be on D0-D7 (PORTD)");
+
+    static uint8_t bitOf(uint8_t button) {
+        return 1 << ButtonPinMap::PINS[button];
+    }
+
+public:
+    /*
+     * Запуск сканера
+     * queue - очередь, в которую пишутся события кнопок
+     */
+    static void begin(InputQueue& queue) {
+        events = &queue;
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            pinMode(ButtonPinMap::PINS[i], INPUT_PULLUP); // Кнопки замыкают на GND
+        }
+        uint8_t sreg = SREG;
+        cli();
+        // Timer2: CTC, предделитель 1024, 62 отсчета (OCR2A = 61) = 3.97 мс; прерывание включается по PCINT
+        TCCR2A = _BV(WGM21);
+        TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);
+        OCR2A = (F_CPU / 1024UL * SAMPLE_MS / 1000UL) - 1;
+        TIMSK2 = 0;
+        PCMSK2 |= MASK;
+        PCIFR = _BV(PCIE2);
+        PCICR |= _BV(PCIE2);
+        startScan(); // Кнопка может быть нажата уже при включении
+        SREG = sreg;
+    }
+
+    /*
+     * Обработка прерывания изменения уровня
+     * Вызывается только из ISR(PCINT2_vect)
+     */
+    static void onPinChange() {
+        startScan();
+    }
+
+    /*
+     * Отсчет: подавление дребезга и генерация событий
+     * Вызывается только из ISR(TIMER2_COMPA_vect)
+     */
+    static void onSample() {
+        uint8_t sample = ~PIND & MASK; // 1 - кнопка нажата
+
+        // Двухбитный вертикальный счетчик на каждый канал: считает отсчеты,
+        // отличные от устойчивого состояния, и сбрасывается при совпадении
+        uint8_t delta = sample ^ state;
+        count1 = (count1 ^ count0) & delta;
+        count0 = ~count0 & delta;
+        uint8_t toggled = delta & ~(count0 | count1); // 4 отсчета подряд
+        state ^= toggled;
+
+        uint16_t now = (uint16_t)SystemTimer::getMillis();
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            uint8_t bit = bitOf(i);
+            if (toggled & bit) {
+                if (state & bit) {
+                    pressSamples[i] = 0; // Нажатие
+                } else if (pressSamples[i] < HOLD_SAMPLES) {
+                    push(INPUT_BUTTON_CLICK, i, now); // Отпускание до удержания
+                }
+            } else if (state & bit) {
+                uint8_t held = ++pressSamples[i];
+                if (held == HOLD_SAMPLES) {
+                    push(INPUT_BUTTON_HOLD, i, now);
+                } else if (held == HOLD_SAMPLES + REPEAT_SAMPLES) {
+                    push(INPUT_BUTTON_REPEAT, i, now);
+                    pressSamples[i] = HOLD_SAMPLES; // Следующий повтор через REPEAT_SAMPLES
+                }
+            }
+        }
+
+        // Все отпущены и ничего не меняется - опрос до следующего PCINT не нужен
+        if (state == 0 && (count0 | count1) == 0) {
+            TIMSK2 = 0;
+        }
+    }
+
+    /*
+     * Нажата ли кнопка сейчас (после подавления дребезга)
+     */
+    static bool isPressed(ButtonId id) {
+        return (state & bitOf(id)) != 0;
+    }
+
+private:
+    static InputQueue* events;     // Очередь событий
+    static volatile uint8_t state; // Устойчивое состояние (биты PORTD, 1 - нажата)
+    static uint8_t count0;         // Младшие биты вертикальных счетчиков
+    static uint8_t count1;         // Старшие биты вертикальных счетчиков
+    static uint8_t pressSamples[BUTTON_COUNT]; // Длительность нажатия в отсчетах
+
+    static void startScan() {
+        if (TIMSK2 & _BV(OCIE2A)) return; // Опрос уже идет
+        TCNT2 = 0;
+        TIFR2 = _BV(OCF2A);
+        TIMSK2 = _BV(OCIE2A);
+    }
+
+    static void push(uint8_t type, uint8_t button, uint16_t time) {
+        events->push({type, button, time});
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    ButtonScanner() = delete;
+};
+
+InputQueue* ButtonScanner::events = nullptr;
+volatile uint8_t ButtonScanner::state = 0;
+uint8_t ButtonScanner::count0 = 0;
+uint8_t ButtonScanner::count1 = 0;
+uint8_t ButtonScanner::pressSamples[BUTTON_COUNT] = {0};
+
+// Изменение уровня на кнопках PORTD: запуск опроса
+ISR(PCINT2_vect) {
+    ButtonScanner::onPinChange();
+}
+
+// Отсчет сканера кнопок (каждые 4 мс, пока идет опрос)
+ISR(TIMER2_COMPA_vect) {
+    ButtonScanner::onSample();
+}
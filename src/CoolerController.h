@@ -1,6 +1,8 @@
 #pragma once
-#include "TemperatureSensor.h"
-#include "EEPROMStorage.h"
+#include "SensorArray.h"
+#include "SettingsStore.h"
+#include "OutputBank.h"
+#include "EventLog.h"
 #include <Arduino.h>
 
 /*
@@ -10,7 +12,7 @@ struct CoolerSettings {
     float targetTemp = 4.0f;     // Целевая температура (°C)
     float hysteresis = 2.0f;     // Гистерезис (°C)
     uint16_t minInterval = 300; // Минимальный интервал между включениями (сек)
-    uint8_t checksum = 0;        // Контрольная сумма
+    uint8_t controlSource = SOURCE_TANK_MAX; // Датчик или агрегат для регулирования (TempSource)
 } __attribute__((packed));
 
 /*
@@ -18,32 +20,24 @@ struct CoolerSettings {
  */
 class CoolerController {
 private:
-    TemperatureSensor& sensor;
-    const uint8_t compressorPin;
+    SensorArray& sensors;
+    OutputBank& outputs;
     CoolerSettings settings;
-    bool compressorState = false;
+    bool compressorState = false;   // Компрессор запрошен регулированием
+    bool running = false;           // Компрессор фактически включен (с учетом блокировок OutputBank)
+    bool manual = false;            // Ручное управление (тестовое меню), регулирование приостановлено
     unsigned long lastStopTime = 0; // Время последнего выключения
 
-    uint8_t calculateChecksum() const {
-        uint8_t sum = 0;
-        const uint8_t* p = reinterpret_cast<const uint8_t*>(&settings);
-        for(size_t i = 0; i < sizeof(settings) - 1; i++) {
-            sum += p[i];
-        }
-        return ~sum; // Инвертированная сумма
-    }
-
 public:
     /*
      * Конструктор
-     * sensorRef - ссылка на датчик температуры
-     * pin - пин управления компрессором
+     * sensorsRef - ссылка на группу датчиков температуры
+     * outputsRef - банк выходов (компрессор - OUT_COMPRESSOR)
      */
-    CoolerController(TemperatureSensor& sensorRef, uint8_t pin) 
-        : sensor(sensorRef), compressorPin(pin) 
+    CoolerController(SensorArray& sensorsRef, OutputBank& outputsRef) 
+        : sensors(sensorsRef), outputs(outputsRef) 
     {
-        pinMode(pin, OUTPUT);
-        digitalWrite(pin, LOW); // Компрессор выключен по умолчанию
+        // Компрессор выключен по умолчанию (OutputBank выключает все выходы)
     }
 
     /*
@@ -51,13 +45,23 @@ public:
      * Должен вызываться в главном цикле программы
      */
     void update() {
+        trackOutput();
+        if (manual) return; // Компрессором управляет тестовое меню
+
+        // Блокировка выключила компрессор (горячее ополаскивание): запрос снимается,
+        // повторное включение - по обычным правилам, не раньше minInterval
+        if (compressorState && (outputs.getHeld() & OUT_COMPRESSOR)) {
+            stopCompressor();
+            return;
+        }
+
         // Если датчик неисправен, выключаем компрессор
-        if (!sensor.isSensorOK()) {
+        if (!sensors.isSensorOK(settings.controlSource)) {
             stopCompressor();
             return;
         }
 
-        float temp = sensor.getTemp();
+        float temp = getControlTemp();
         unsigned long now = millis();
         unsigned long minIntervalMs = (unsigned long)settings.minInterval * 1000UL;
 
@@ -77,13 +81,37 @@ public:
         }
     }
 
+    /*
+     * Температура, по которой ведется регулирование (°C)
+     */
+    float getControlTemp() const {
+        return sensors.getTemp(settings.controlSource);
+    }
+
+    /*
+     * Исправность источника температуры регулирования
+     */
+    bool isControlSensorOK() const {
+        return sensors.isSensorOK(settings.controlSource);
+    }
+
+    /*
+     * Температура регулирования в сотых долях градуса
+     */
+    int16_t getControlTempCenti() const {
+        return sensors.getTempCenti(settings.controlSource);
+    }
+
     /*
      * Включение компрессора
      */
     void startCompressor() {
+        // Пока блокировка не даст включить компрессор, запрос не ставится
+        if (Interlock::conflicts(outputs.getState() | OUT_COMPRESSOR) & OUT_COMPRESSOR) return;
         if (!compressorState) { // Включаем только если он выключен
-            digitalWrite(compressorPin, HIGH);
+            outputs.set(OUT_COMPRESSOR, true);
             compressorState = true;
+            trackOutput();
         }
     }
 
@@ -92,12 +120,33 @@ public:
      */
     void stopCompressor() {
         if (compressorState) { // Выключаем только если он включен
-            digitalWrite(compressorPin, LOW);
+            outputs.set(OUT_COMPRESSOR, false);
             compressorState = false;
             lastStopTime = millis(); // Запоминаем время выключения
+            trackOutput();
         }
     }
 
+    /*
+     * Учет фактического состояния выхода компрессора
+     * Блокировка OutputBank может удерживать запрошенный компрессор выключенным
+     * и включить его позже, поэтому журнал пишется по выходу, а не по запросу
+     */
+    void trackOutput() {
+        bool on = outputs.isOn(OUT_COMPRESSOR);
+        if (on == running) return;
+        running = on;
+        if (!on) lastStopTime = millis(); // Минимальный интервал - от фактической остановки
+        EventLog::append(on ? LOG_COMPRESSOR_ON : LOG_COMPRESSOR_OFF);
+    }
+
+    /*
+     * Ручное управление: пока включено, update() не меняет состояние компрессора
+     */
+    void setManual(bool on) {
+        manual = on;
+    }
+
     /*
      * Установка состояния компрессора (для тестирования)
      * state - true для включения, false для выключения
@@ -111,35 +160,33 @@ public:
     }
 
     /*
-     * Загрузка настроек из EEPROM
-     * Возвращает true, если настройки загружены успешно и контрольная сумма верна
+     * Сброс настроек к значениям по умолчанию (из SettingsStore)
      */
-    bool loadSettings() {
-        constexpr int address = 0; // Адрес начала настроек компрессора в EEPROM
-        EEPROMStorage::read(address, settings);
-        // Если контрольная сумма не совпадает, сбрасываем к настройкам по умолчанию
-        if(settings.checksum != calculateChecksum()) {
-            settings = CoolerSettings(); // Инициализация дефолтными значениями
-            return false;
-        }
-        return true;
+    void resetSettings() {
+        settings = CoolerSettings();
+    }
+
+    /*
+     * Проверка загруженных настроек (из SettingsStore)
+     * Возвращает false, если значения недопустимы
+     */
+    bool applySettings() const {
+        return settings.controlSource < SOURCE_COUNT && settings.hysteresis >= 0.0f;
     }
 
     /*
      * Сохранение настроек в EEPROM
      */
     void saveSettings() {
-        settings.checksum = calculateChecksum(); // Обновляем контрольную сумму перед сохранением
-        constexpr int address = 0;
-        EEPROMStorage::write(address, settings);
+        SettingsStore::save(SETTINGS_COOLER);
     }
 
     /*
      * Проверка состояния компрессора
-     * Возвращает true, если компрессор включен
+     * Возвращает true, если выход компрессора включен (не удержан блокировкой)
      */
     bool isRunning() const { 
-        return compressorState; 
+        return outputs.isOn(OUT_COMPRESSOR); 
     }
     
     /*
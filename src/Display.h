@@ -1,54 +1,41 @@
 #pragma once
-#include <LiquidCrystal_I2C.h>
-#include <avr/pgmspace.h> // Для работы с PROGMEM
-#include <string.h>       // Для strcmp, strcpy, strncpy, memset
-#include <stdio.h>        // Для snprintf
-#include <stdlib.h>       // Для dtostrf, itoa
+#include "LcdDriver.h"
+#include "Format.h"
 
+/*
+ * Экраны системы
+ * Строки пишутся в буфер кадра LcdDriver и выводятся на LCD в фоне
+ */
 class Display {
-private:
-    LiquidCrystal_I2C& lcd;
-    char prevLine0[17]; // Буфер для предыдущего состояния первой строки
-    char prevLine1[17]; // Буфер для предыдущего состояния второй строки
-
-    // Строка для очистки строки дисплея, хранится в PROGMEM
-    static const char clearLine[] PROGMEM;
+public:
+    // Буфер строки с запасом: все, что длиннее 16 символов, отсекает LcdDriver::setLine
+    static const uint8_t LINE_BUFFER = 33;
 
+private:
     /*
-     * Вспомогательная функция для печати строки из PROGMEM
-     * (используется для внутренней логики, чтобы избежать повторного считывания)
+     * Обновляет строку в буфере кадра и запускает фоновый вывод
+     * Строка выводится, только если содержимое изменилось
      */
-    void printFromProgmem(const char* str) {
-        char c;
-        while ((c = pgm_read_byte(str++))) {
-            lcd.write(c);
-        }
+    void updateLine(uint8_t row, const char* newLine) {
+        LcdDriver::setLine(row, newLine);
+        LcdDriver::flush();
     }
 
+public:
     /*
-     * Обновляет строку на LCD, только если содержимое изменилось
+     * Запуск дисплея (из setup())
+     * i2cAddress - адрес PCF8574
      */
-    void updateLine(uint8_t row, const char* newLine) {
-        char* prevLine = (row == 0) ? prevLine0 : prevLine1;
-
-        if (strcmp(newLine, prevLine) != 0) { // Сравниваем текущую строку с предыдущей
-            lcd.setCursor(0, row);
-            printFromProgmem(clearLine); // Очищаем строку, читая из PROGMEM
-            lcd.setCursor(0, row);
-            lcd.print(newLine);
-            strcpy(prevLine, newLine); // Сохраняем новую строку как предыдущую
-        }
+    void begin(uint8_t i2cAddress) {
+        LcdDriver::begin(i2cAddress);
     }
 
-public:
     /*
-     * Конструктор
-     * lcdInstance - ссылка на объект LiquidCrystal_I2C
+     * Продолжение фонового вывода (после ошибки шины)
+     * Возвращает количество еще не выведенных символов
      */
-    Display(LiquidCrystal_I2C& lcdInstance) : lcd(lcdInstance) {
-        // Инициализация буферов нулями
-        memset(prevLine0, 0, sizeof(prevLine0));
-        memset(prevLine1, 0, sizeof(prevLine1));
+    uint8_t flush() {
+        return LcdDriver::flush();
     }
 
     /*
@@ -58,27 +45,37 @@ public:
      * total - общее количество пунктов
      */
     void showMenuScreen(const char* item, uint8_t current, uint8_t total) {
-        char line0[17], line1[17];
-        snprintf(line0, sizeof(line0), "%s", item);
-        snprintf(line1, sizeof(line1), "%d/%d", current, total);
-        updateLine(0, line0);
+        char line1[LINE_BUFFER];
+        char* p = Format::unsignedInt(line1, current);
+        p = Format::character(p, '/');
+        Format::unsignedInt(p, total);
+        updateLine(0, item);
         updateLine(1, line1);
     }
 
     /*
      * Отображает главный экран с температурой, состоянием миксера и компрессора
+     * tempCenti - температура в сотых долях градуса
+     * tempOK - датчик исправен; иначе вместо температуры выводится "ERR"
      */
-    void showMainScreen(float temperature, bool mixerState, bool coolerState) {
-        char line0[17]; // Достаточно для "Temp: -XX.X C"
-        char line1[17]; // Достаточно для "Mix:ON Cool:OFF"
-        
-        // Форматирование первой строки: "Temp: XX.X C"
-        snprintf(line0, sizeof(line0), "Temp: %5.1f C", temperature);
-        
-        // Форматирование второй строки: "Mix: ON/OFF Cool: ON/OFF"
-        snprintf(line1, sizeof(line1), "Mix:%s Cool:%s", 
-                 mixerState ? "ON " : "OFF", // Добавлен пробел для выравнивания
-                 coolerState ? "ON" : "OFF");
+    void showMainScreen(int16_t tempCenti, bool tempOK, bool mixerState, bool coolerState) {
+        char line0[LINE_BUFFER]; // "Temp: -XX.X C" или "Temp: ERR"
+        char line1[LINE_BUFFER]; // "Mix:ON  Cool:OFF"
+
+        // Первая строка: "Temp: XX.X C"
+        char* p = Format::text(line0, "Temp: ");
+        if (tempOK) {
+            p = Format::tempCenti(p, tempCenti, 5);
+            Format::text(p, " C");
+        } else {
+            Format::text(p, "ERR");
+        }
+
+        // Вторая строка: "Mix: ON/OFF Cool: ON/OFF"
+        p = Format::text(line1, "Mix:");
+        p = Format::text(p, mixerState ? "ON " : "OFF"); // Добавлен пробел для выравнивания
+        p = Format::text(p, " Cool:");
+        Format::text(p, coolerState ? "ON" : "OFF");
 
         updateLine(0, line0);
         updateLine(1, line1);
@@ -88,31 +85,45 @@ public:
      * Отображает экран процесса мойки
      */
     void showWashingScreen(const char* stage, int remainingTime) {
-        char line0[17], line1[17];
-        
-        // Форматирование первой строки: "Stage: <Stage Name>"
-        snprintf(line0, sizeof(line0), "Stage: %s", stage);
-        
-        // Форматирование второй строки: "Time: XXs"
-        snprintf(line1, sizeof(line1), "Time: %ds", remainingTime);
-        
+        char line0[LINE_BUFFER], line1[LINE_BUFFER];
+
+        // Первая строка: "Stage: <Stage Name>"
+        Format::text(Format::text(line0, "Stage: "), stage);
+
+        // Вторая строка: "Time: XXs"
+        Format::character(Format::signedInt(Format::text(line1, "Time: "), remainingTime), 's');
+
+        updateLine(0, line0);
+        updateLine(1, line1);
+    }
+
+    /*
+     * Отображает вопрос оператору в две строки
+     */
+    void showPrompt(const char* question, const char* options) {
+        updateLine(0, question);
+        updateLine(1, options);
+    }
+
+    /*
+     * Отображает экран диагностики памяти
+     * minFree - минимум свободной RAM за время работы, freeNow - сейчас, heap - занятая куча
+     */
+    void showMemoryScreen(uint16_t minFree, uint16_t freeNow, uint16_t heap) {
+        char line0[LINE_BUFFER]; // "RAM min:1234"
+        char line1[LINE_BUFFER]; // "now:1300 heap:0"
+        Format::unsignedInt(Format::text(line0, "RAM min:"), minFree);
+        char* p = Format::unsignedInt(Format::text(line1, "now:"), freeNow);
+        Format::unsignedInt(Format::text(p, " heap:"), heap);
         updateLine(0, line0);
         updateLine(1, line1);
     }
 
     /*
-     * Отображает временное сообщение на дисплее (очищает обе строки)
+     * Отображает временное сообщение на дисплее (вторая строка очищается)
      */
     void showMessage(const char* message) {
-        lcd.clear(); // Очищаем весь дисплей
-        lcd.setCursor(0, 0);
-        lcd.print(message);
-        // Обновляем prevLine0 и очищаем prevLine1 для корректной работы updateLine
-        strncpy(prevLine0, message, 16);
-        prevLine0[16] = '\0';
-        prevLine1[0] = '\0'; // Гарантируем, что вторая строка будет обновлена следующим вызовом updateLine
+        updateLine(0, message);
+        updateLine(1, "");
     }
 };
-
-// Строка для очистки дисплея, хранится в PROGMEM
-const char Display::clearLine[] PROGMEM = "                "; // 16 пробелов
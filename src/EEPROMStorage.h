@@ -1,16 +1,49 @@
 #pragma once
 #include <EEPROM.h>
-#include <Arduino.h> // Для size_t
+#include <Arduino.h>       // Для size_t
+#include <avr/interrupt.h> // Для ISR()
+#include <util/atomic.h>   // Для ATOMIC_BLOCK
 
 /*
  * Класс для работы с EEPROM
  * Реализует:
- * - Чтение/запись любых типов данных
+ * - Чтение/запись любых типов данных и блоков байтов
  * - Очистку EEPROM
- * - Оптимизированную запись (только при изменении)
+ * - Кэш области настроек (первые CACHE_SIZE байт) с отложенной записью:
+ *   запись меняет RAM-копию и помечает байты, а в EEPROM они уходят
+ *   по одному из прерывания готовности EEPROM (EE_READY), без ожидания
+ *   в главном цикле. Повторные изменения байта до его записи
+ *   сливаются в одну физическую запись.
+ * - Оптимизированную запись вне кэша (только изменившиеся байты, с ожиданием)
+ * - Очередь фоновой записи небольших блоков вне кэша (записи журналов):
+ *   блок копируется в очередь и пишется тем же прерыванием после байтов кэша;
+ *   совпадающие с EEPROM байты пропускаются
+ *
+ * Прерывание EE_READY занято этим классом: все обращения к EEPROM должны
+ * идти через EEPROMStorage, иначе запись из прерывания может перебить
+ * адрес или данные прямого обращения.
  */
 class EEPROMStorage {
 public:
+    static const int CACHE_SIZE = 128; // Размер кэшируемой области (с адреса 0)
+    // Блоков в очереди фоновой записи (занято может быть на один меньше).
+    // Всплеск при запуске: boot, watchdog, settings reset и сбой каждого
+    // из 4 датчиков - 7 записей, пока очередь ждет записи кэша настроек
+    static const uint8_t QUEUE_BLOCKS = 8;
+    static const uint8_t QUEUE_BLOCK_SIZE = 12; // Максимальный размер блока (байт)
+
+    /*
+     * Загрузка кэша из EEPROM (из setup(), до первого чтения настроек)
+     */
+    static void begin() {
+        for (int i = 0; i < CACHE_SIZE; i++) cache[i] = EEPROM.read(i);
+        memset(dirty, 0, sizeof(dirty));
+        dirtyCount = 0;
+        scanIndex = 0;
+        queueHead = queueTail = 0;
+        queueOffset = 0;
+    }
+
     /*
      * Чтение данных из EEPROM
      * address - начальный адрес в EEPROM
@@ -18,25 +51,125 @@ public:
      */
     template <typename T>
     static void read(int address, T &data) {
-        EEPROM.get(address, data);
+        readBytes(address, &data, sizeof(T));
     }
 
     /*
      * Запись данных в EEPROM (только если изменились)
      * address - начальный адрес в EEPROM
      * data - ссылка на объект, данные которого будут записаны
+     * Возвращает true, если изменился хотя бы один байт
      */
     template <typename T>
-    static void write(int address, const T &data) {
-        // Читаем текущие данные из EEPROM
-        T currentData;
-        EEPROM.get(address, currentData);
-
-        // Сравниваем новые данные с текущими
-        if (memcmp(&currentData, &data, sizeof(T)) != 0) {
-            // Если данные отличаются, записываем новые
-            EEPROM.put(address, data);
+    static bool write(int address, const T &data) {
+        return writeBytes(address, &data, sizeof(T));
+    }
+
+    /*
+     * Фоновая запись блока вне кэша (только из главного цикла)
+     * Возвращает false, если очередь заполнена или блок не подходит.
+     * Пока блок в очереди, чтение этих адресов возвращает старые данные.
+     */
+    static bool writeAsync(int address, const void* data, uint8_t size) {
+        if (address < CACHE_SIZE || size == 0 || size > QUEUE_BLOCK_SIZE) return false;
+        uint8_t next = (queueTail + 1) % QUEUE_BLOCKS;
+        if (next == queueHead) return false;
+        PendingBlock& block = queue[queueTail];
+        block.address = address;
+        block.size = size;
+        memcpy(block.data, data, size);
+        __asm__ __volatile__("" ::: "memory"); // Блок заполнен до публикации индекса
+        queueTail = next;
+        EECR |= _BV(EERIE);
+        return true;
+    }
+
+    /*
+     * Чтение одного байта (из кэша, если адрес в кэшируемой области)
+     */
+    static uint8_t readByte(int address) {
+        if (address < CACHE_SIZE) return cache[address];
+        suspendCommit();
+        uint8_t value = EEPROM.read(address);
+        resumeCommit();
+        return value;
+    }
+
+    /*
+     * Чтение блока байтов
+     */
+    static void readBytes(int address, void* data, size_t size) {
+        uint8_t* p = static_cast<uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) p[i] = readByte(address + i);
+    }
+
+    /*
+     * Запись одного байта (только если изменился)
+     * В кэшируемой области - без ожидания, иначе - до 3.3 мс
+     * Возвращает true, если значение изменилось
+     */
+    static bool writeByte(int address, uint8_t value) {
+        bool changed = false;
+        if (address < CACHE_SIZE) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                changed = cache[address] != value;
+                if (changed) {
+                    cache[address] = value;
+                    uint8_t mask = 1 << (address & 7);
+                    if (!(dirty[address >> 3] & mask)) {
+                        dirty[address >> 3] |= mask;
+                        dirtyCount++;
+                    }
+                    EECR |= _BV(EERIE); // Запись начнется, как только EEPROM свободна
+                }
+            }
+            return changed;
+        }
+        suspendCommit();
+        changed = EEPROM.read(address) != value;
+        if (changed) EEPROM.write(address, value);
+        resumeCommit();
+        return changed;
+    }
+
+    /*
+     * Запись блока байтов (пишутся только изменившиеся ячейки)
+     * Возвращает true, если изменился хотя бы один байт
+     */
+    static bool writeBytes(int address, const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bool changed = false;
+        for (size_t i = 0; i < size; i++) {
+            if (writeByte(address + i, p[i])) changed = true;
         }
+        return changed;
+    }
+
+    /*
+     * Количество байтов кэша, еще не записанных в EEPROM
+     */
+    static uint8_t getPending() {
+        return dirtyCount;
+    }
+
+    /*
+     * Барьер порядка записи: ожидание записи всех измененных байтов кэша
+     * Прерывание пишет кэш в порядке адресов, а не изменений; байты, измененные
+     * после барьера, гарантированно попадут в EEPROM позже предыдущих.
+     * До CACHE_SIZE * 3.3 мс; прерывания должны быть разрешены
+     */
+    static void flushCache() {
+        while (dirtyCount != 0);
+        while (EECR & _BV(EEPE));
+    }
+
+    /*
+     * Ожидание записи всех измененных байтов и очереди (перед намеренным сбросом)
+     * До (CACHE_SIZE + очередь) * 3.3 мс в худшем случае; прерывания должны быть разрешены
+     */
+    static void flush() {
+        while (dirtyCount != 0 || queueHead != queueTail);
+        while (EECR & _BV(EEPE));
     }
 
     /*
@@ -46,13 +179,114 @@ public:
      */
     static void clear() {
         for (size_t i = 0; i < EEPROM.length(); ++i) {
-            if (EEPROM.read(i) != 0) { // Записываем 0 только если значение не 0
-                EEPROM.write(i, 0);
-            }
+            writeByte(i, 0); // Записываем 0 только если значение не 0
+        }
+    }
+
+    /*
+     * Запись следующего измененного байта кэша
+     * Вызывается только из ISR(EE_READY_vect): EEPROM свободна
+     */
+    static void onReady() {
+        if (dirtyCount == 0) {
+            commitQueue();
+            return;
+        }
+        // Поиск по кругу от последней записанной ячейки, целыми байтами маски
+        uint8_t index = scanIndex;
+        for (;;) {
+            uint8_t bits = dirty[index >> 3];
+            if (bits & (1 << (index & 7))) break;
+            // Пустой байт маски пропускается целиком
+            index = (bits == 0) ? ((index | 7) + 1) & (CACHE_SIZE - 1) : (index + 1) & (CACHE_SIZE - 1);
         }
+
+        dirty[index >> 3] &= ~(1 << (index & 7));
+        dirtyCount--;
+        scanIndex = (index + 1) & (CACHE_SIZE - 1);
+
+        program(index, cache[index]);
     }
 
 private:
+    // Блок фоновой записи
+    struct PendingBlock {
+        uint16_t address;
+        uint8_t size;
+        uint8_t data[QUEUE_BLOCK_SIZE];
+    };
+
+    static_assert((CACHE_SIZE & (CACHE_SIZE - 1)) == 0 && CACHE_SIZE <= 256,
+                  "EEPROMStorage: CACHE_SIZE must be a power of two up to 256");
+
+    static uint8_t cache[CACHE_SIZE];          // Копия кэшируемой области
+    static uint8_t dirty[CACHE_SIZE / 8];      // Байты, ожидающие записи (бит на байт)
+    static volatile uint8_t dirtyCount;        // Количество ожидающих байтов
+    static uint8_t scanIndex;                  // С какой ячейки искать следующую
+    static PendingBlock queue[QUEUE_BLOCKS];   // Очередь фоновой записи
+    static volatile uint8_t queueHead;         // Записываемый блок (меняет прерывание)
+    static volatile uint8_t queueTail;         // Свободное место (меняет главный цикл)
+    static uint8_t queueOffset;                // Следующий байт записываемого блока
+
+    /*
+     * Стирание и запись байта: EEPE не позже 4 тактов после EEMPE
+     */
+    static void program(uint16_t address, uint8_t value) {
+        EEAR = address;
+        EEDR = value;
+        EECR |= _BV(EEMPE);
+        EECR |= _BV(EEPE);
+    }
+
+    /*
+     * Запись следующего отличающегося байта из очереди блоков
+     * Если записывать нечего - прерывание выключается
+     */
+    static void commitQueue() {
+        while (queueHead != queueTail) {
+            const PendingBlock& block = queue[queueHead];
+            uint16_t address = block.address + queueOffset;
+            uint8_t value = block.data[queueOffset];
+            if (++queueOffset >= block.size) {
+                queueOffset = 0;
+                queueHead = (queueHead + 1) % QUEUE_BLOCKS; // Место освобождается заранее
+            }
+            EEAR = address;
+            EECR |= _BV(EERE); // Чтение занимает 4 такта, EEPROM свободна
+            if (EEDR != value) {
+                program(address, value);
+                return;
+            }
+        }
+        EECR &= ~_BV(EERIE);
+    }
+
+    /*
+     * Прямое обращение к EEPROM вне кэша: запись из прерывания
+     * приостанавливается, текущая физическая запись дожидается библиотекой EEPROM
+     */
+    static void suspendCommit() {
+        EECR &= ~_BV(EERIE);
+    }
+
+    static void resumeCommit() {
+        if (dirtyCount != 0 || queueHead != queueTail) EECR |= _BV(EERIE);
+    }
+
     // Запрещаем создание экземпляров класса, так как это статический класс
-    EEPROMStorage() = delete; 
+    EEPROMStorage() = delete;
 };
+
+uint8_t EEPROMStorage::cache[CACHE_SIZE];
+uint8_t EEPROMStorage::dirty[CACHE_SIZE / 8];
+volatile uint8_t EEPROMStorage::dirtyCount = 0;
+uint8_t EEPROMStorage::scanIndex = 0;
+EEPROMStorage::PendingBlock EEPROMStorage::queue[QUEUE_BLOCKS];
+volatile uint8_t EEPROMStorage::queueHead = 0;
+volatile uint8_t EEPROMStorage::queueTail = 0;
+uint8_t EEPROMStorage::queueOffset = 0;
+
+// EEPROM свободна: запись следующего измененного байта кэша или очереди
+ISR(EE_READY_vect) {
+    EEPROMStorage::onReady();
+}
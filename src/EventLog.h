@@ -0,0 +1,225 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h> // Для PROGMEM
+#include <util/crc16.h>   // Для _crc8_ccitt_update
+#include "EEPROMStorage.h"
+#include "SystemTimer.h"
+
+/*
+ * Коды событий журнала (value - параметр события)
+ */
+enum LogCode : uint8_t {
+    LOG_BOOT,           // Запуск прошивки (value - флаги MCUSR)
+    LOG_COMPRESSOR_ON,  // Компрессор включен
+    LOG_COMPRESSOR_OFF, // Компрессор выключен
+    LOG_SENSOR_FAULT,   // Датчик неисправен (value - ProbeId)
+    LOG_SENSOR_OK,      // Датчик снова исправен (value - ProbeId)
+    LOG_WASH_START,     // Начало мойки (value - RecipeId)
+    LOG_WASH_DONE,      // Мойка завершена (value - 1, если температура не достигнута)
+    LOG_WASH_STOP,      // Мойка остановлена до завершения (value - шаг)
+    LOG_SETTINGS_SAVED, // Сохранен блок настроек (value - SettingsBlockId)
+    LOG_SETTINGS_RESET, // Блоки настроек сброшены при загрузке (value - маска SettingsBlockId)
+    LOG_WATCHDOG,       // Сброс по сторожевому таймеру (value - номер задачи, -1 - вне задач)
+    LOG_INTERLOCK,      // Выходы удержаны блокировкой (value - биты Output)
+    LOG_DROPPED,        // Потеряны события: очередь записи была заполнена (value - сколько)
+    LOG_CODE_COUNT
+};
+
+/*
+ * Запись журнала событий (10 байт)
+ */
+struct EventRecord {
+    uint16_t seq;    // Порядковый номер записи
+    uint32_t uptime; // Время от запуска (сек)
+    uint8_t code;    // Код события (LogCode)
+    int16_t value;   // Параметр события
+    uint8_t crc;     // CRC-8 предыдущих полей
+} __attribute__((packed));
+
+// Названия событий в PROGMEM (для вывода журнала)
+const char logNameBoot[] PROGMEM = "boot";
+const char logNameCompressorOn[] PROGMEM = "compressor on";
+const char logNameCompressorOff[] PROGMEM = "compressor off";
+const char logNameSensorFault[] PROGMEM = "sensor fault";
+const char logNameSensorOk[] PROGMEM = "sensor ok";
+const char logNameWashStart[] PROGMEM = "wash start";
+const char logNameWashDone[] PROGMEM = "wash done";
+const char logNameWashStop[] PROGMEM = "wash stop";
+const char logNameSettingsSaved[] PROGMEM = "settings saved";
+const char logNameSettingsReset[] PROGMEM = "settings reset";
+const char logNameWatchdog[] PROGMEM = "watchdog";
+const char logNameInterlock[] PROGMEM = "interlock";
+const char logNameDropped[] PROGMEM = "events dropped";
+
+const char* const logNames[LOG_CODE_COUNT] PROGMEM = {
+    logNameBoot, logNameCompressorOn, logNameCompressorOff, logNameSensorFault,
+    logNameSensorOk, logNameWashStart, logNameWashDone, logNameWashStop, logNameSettingsSaved,
+    logNameSettingsReset, logNameWatchdog, logNameInterlock, logNameDropped
+};
+
+/*
+ * Журнал событий и аварий в EEPROM
+ * Реализует:
+ * - Кольцо записей фиксированного размера с выравниванием износа:
+ *   каждая запись идет в следующую ячейку, ячейка переписывается раз за круг
+ * - Порядковые номера: записи от начала кольца до головы идут подряд,
+ *   поэтому голова находится двоичным поиском за O(log n) чтений при запуске
+ * - Добавление за O(1) без ожидания EEPROM: запись уходит в очередь
+ *   фоновой записи EEPROMStorage
+ * - Учет потерь: события, не поместившиеся в очередь, отмечаются записью
+ *   LOG_DROPPED, как только в очереди появится место
+ * - Вывод журнала в Serial от старых записей к новым
+ *
+ * 76 ячеек по 10 байт от адреса 256 до конца EEPROM: при 100 000 циклов
+ * на ячейку журнал выдерживает около 7 млн событий.
+ * Запись, прерванная сбросом, не проходит проверку CRC и не считается головой.
+ */
+class EventLog {
+public:
+    static const uint8_t SLOTS = 76; // Ячеек в кольце
+    static const int SIZE = SLOTS * sizeof(EventRecord); // Размер области в EEPROM
+
+    /*
+     * Поиск головы кольца (из setup(), после EEPROMStorage::begin())
+     * address - начало области журнала в EEPROM (вне кэша EEPROMStorage)
+     */
+    static void begin(int address) {
+        baseAddress = address;
+        started = true;
+        EventRecord first;
+        if (!readSlot(0, first)) {
+            // Пустой журнал или сброс во время записи первой ячейки нового круга
+            EventRecord last;
+            head = SLOTS - 1;
+            nextSeq = readSlot(SLOTS - 1, last) ? last.seq + 1 : 0;
+            return;
+        }
+        // Ячейки 0..head содержат номера first.seq + i, дальше - прошлый круг или пусто
+        uint8_t low = 0;
+        uint8_t high = SLOTS - 1;
+        while (low < high) {
+            uint8_t middle = (low + high + 1) / 2;
+            EventRecord record;
+            if (readSlot(middle, record) && (uint16_t)(record.seq - first.seq) == middle) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+        head = low;
+        nextSeq = first.seq + low + 1;
+    }
+
+    /*
+     * Добавление записи (только из главного цикла, без ожидания EEPROM)
+     * Если очередь записи заполнена, событие теряется и учитывается в getDropped()
+     * и в следующей записи LOG_DROPPED
+     */
+    static void append(uint8_t code, int16_t value = 0) {
+        if (!started) return;
+        update();
+        if (!push(code, value)) {
+            if (dropped < 0xFF) dropped++;
+            if (unreported < 0xFF) unreported++;
+        }
+    }
+
+    /*
+     * Запись LOG_DROPPED о потерянных событиях, если в очереди появилось место
+     * (из главного цикла; append() делает это сам)
+     */
+    static void update() {
+        if (unreported != 0 && push(LOG_DROPPED, unreported)) unreported = 0;
+    }
+
+    /*
+     * Количество событий, потерянных из-за заполненной очереди записи
+     */
+    static uint8_t getDropped() {
+        return dropped;
+    }
+
+    /*
+     * Вывод журнала в Serial: "номер время_с событие параметр"
+     * Записи, еще стоящие в очереди записи, появятся в следующем выводе
+     */
+    static void print(Print& out) {
+        out.println(F("seq uptime_s event value"));
+        uint8_t slot = head;
+        for (uint8_t n = 0; n < SLOTS; n++) {
+            slot = (slot + 1 == SLOTS) ? 0 : slot + 1; // От самой старой ячейки
+            EventRecord record;
+            if (!readSlot(slot, record)) continue;
+            out.print(record.seq);
+            out.print(' ');
+            out.print(record.uptime);
+            out.print(' ');
+            if (record.code < LOG_CODE_COUNT) {
+                out.print((const __FlashStringHelper*)pgm_read_ptr(&logNames[record.code]));
+            } else {
+                out.print(record.code); // Код из более новой прошивки
+            }
+            out.print(' ');
+            out.println(record.value);
+        }
+        out.print(F("dropped: "));
+        out.println(dropped);
+    }
+
+private:
+    static int baseAddress;  // Начало кольца в EEPROM
+    static bool started;     // begin() выполнен
+    static uint8_t head;     // Ячейка последней записи
+    static uint16_t nextSeq; // Номер следующей записи
+    static uint8_t dropped;  // Потерянные события
+    static uint8_t unreported; // Потерянные события, еще не отмеченные записью LOG_DROPPED
+
+    /*
+     * CRC-8 записи (полином 0x07, начальное значение 0xFF)
+     */
+    static uint8_t calculateCrc(const EventRecord& record) {
+        uint8_t crc = 0xFF;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&record);
+        for (size_t i = 0; i < sizeof(record) - 1; i++) {
+            crc = _crc8_ccitt_update(crc, p[i]);
+        }
+        return crc;
+    }
+
+    /*
+     * Постановка записи в очередь EEPROMStorage
+     * Возвращает false, если очередь заполнена
+     */
+    static bool push(uint8_t code, int16_t value) {
+        EventRecord record;
+        record.seq = nextSeq;
+        record.uptime = SystemTimer::getMillis() / 1000UL;
+        record.code = code;
+        record.value = value;
+        record.crc = calculateCrc(record);
+        uint8_t slot = (head + 1 == SLOTS) ? 0 : head + 1;
+        if (!EEPROMStorage::writeAsync(slotAddress(slot), &record, sizeof(record))) return false;
+        head = slot;
+        nextSeq++;
+        return true;
+    }
+
+    static int slotAddress(uint8_t slot) {
+        return baseAddress + slot * sizeof(EventRecord);
+    }
+
+    static bool readSlot(uint8_t slot, EventRecord& record) {
+        EEPROMStorage::read(slotAddress(slot), record);
+        return record.crc == calculateCrc(record);
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    EventLog() = delete;
+};
+
+int EventLog::baseAddress = 0;
+bool EventLog::started = false;
+uint8_t EventLog::head = EventLog::SLOTS - 1;
+uint16_t EventLog::nextSeq = 0;
+uint8_t EventLog::dropped = 0;
+uint8_t EventLog::unreported = 0;
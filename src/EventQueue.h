@@ -0,0 +1,74 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * Очередь событий без блокировок: один писатель, один читатель
+ * Реализует:
+ * - Кольцевой буфер на SIZE элементов (степень двойки, до 128)
+ * - Запись из прерывания и чтение из главного цикла без запрета прерываний:
+ *   каждый индекс меняет только одна сторона, а чтение байта на AVR атомарно
+ * - Подсчет событий, потерянных из-за переполнения
+ *
+ * Писатель сначала записывает элемент, затем сдвигает head; барьер памяти
+ * не дает компилятору переставить эти записи.
+ */
+template <typename T, uint8_t SIZE>
+class EventQueue {
+    static_assert(SIZE >= 2 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0,
+                  "EventQueue: SIZE must be a power of two up to 128");
+
+private:
+    T buffer[SIZE];
+    volatile uint8_t head;    // Следующая ячейка для записи (меняет только писатель)
+    volatile uint8_t tail;    // Следующая ячейка для чтения (меняет только читатель)
+    volatile uint8_t dropped; // Потеряно событий (насыщается на 255)
+
+    static void barrier() {
+        __asm__ __volatile__("" ::: "memory");
+    }
+
+public:
+    EventQueue() : head(0), tail(0), dropped(0) {}
+
+    /*
+     * Добавление события (сторона писателя, обычно прерывание)
+     * Возвращает false, если очередь заполнена
+     */
+    bool push(const T& event) {
+        uint8_t h = head;
+        uint8_t next = (h + 1) & (SIZE - 1);
+        if (next == tail) {
+            if (dropped < 0xFF) dropped++;
+            return false;
+        }
+        buffer[h] = event;
+        barrier();
+        head = next;
+        return true;
+    }
+
+    /*
+     * Извлечение события (сторона читателя, главный цикл)
+     * Возвращает false, если очередь пуста
+     */
+    bool pop(T& event) {
+        uint8_t t = tail;
+        if (t == head) return false;
+        barrier();
+        event = buffer[t];
+        barrier();
+        tail = (t + 1) & (SIZE - 1);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return head == tail;
+    }
+
+    /*
+     * Количество потерянных событий
+     */
+    uint8_t getDropped() const {
+        return dropped;
+    }
+};
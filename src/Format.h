@@ -0,0 +1,145 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h> // Для pgm_read_byte
+
+// Прежний способ вывода дробных чисел для сравнения размера прошивки:
+// 1 - snprintf("%f") и dtostrf() (окружение [env:size_printf]), 0 - свой вывод
+#ifndef FORMAT_USE_PRINTF
+#define FORMAT_USE_PRINTF 0
+#endif
+
+#if FORMAT_USE_PRINTF
+#include <stdio.h>  // snprintf
+#include <stdlib.h> // dtostrf
+#endif
+
+/*
+ * Форматирование чисел и строк в буфер без printf
+ * Реализует:
+ * - Целые со знаком и без, с шириной поля и символом заполнения
+ * - Числа в фиксированной точке (значение уже умножено на 10^decimals)
+ * - Температуру из сотых долей градуса с округлением до десятых
+ * - Копирование строк из RAM и PROGMEM
+ *
+ * Каждая функция пишет с позиции out, ставит завершающий ноль
+ * и возвращает указатель на него, поэтому вызовы можно объединять в цепочку:
+ *     char* p = Format::text(line, "Temp: ");
+ *     p = Format::tempCenti(p, temp, 5);
+ *
+ * Заменяет snprintf("%f") и dtostrf(): в avr-libc по умолчанию
+ * printf не поддерживает float, а dtostrf тянет за собой плавающую арифметику.
+ * Размер буфера проверяет вызывающий код (строка LCD - 16 символов).
+ */
+class Format {
+public:
+    /*
+     * Копирование строки из RAM
+     */
+    static char* text(char* out, const char* s) {
+        while (*s) *out++ = *s++;
+        *out = '\0';
+        return out;
+    }
+
+    /*
+     * Копирование строки из PROGMEM
+     */
+    static char* textP(char* out, const char* s) {
+        char c;
+        while ((c = pgm_read_byte(s++))) *out++ = c;
+        *out = '\0';
+        return out;
+    }
+
+    /*
+     * Один символ
+     */
+    static char* character(char* out, char c) {
+        *out++ = c;
+        *out = '\0';
+        return out;
+    }
+
+    /*
+     * Целое без знака
+     * width - минимальная ширина поля (выравнивание вправо), pad - символ заполнения
+     */
+    static char* unsignedInt(char* out, uint16_t value, uint8_t width = 0, char pad = ' ') {
+        return number(out, value, false, 0, width, pad);
+    }
+
+    /*
+     * Целое со знаком
+     */
+    static char* signedInt(char* out, int16_t value, uint8_t width = 0, char pad = ' ') {
+        bool negative = value < 0;
+        return number(out, negative ? -(uint16_t)value : (uint16_t)value, negative, 0, width, pad);
+    }
+
+    /*
+     * Число в фиксированной точке
+     * value - значение, умноженное на 10^decimals (например, 45 и 1 -> "4.5")
+     */
+    static char* fixed(char* out, int16_t value, uint8_t decimals, uint8_t width = 0, char pad = ' ') {
+#if FORMAT_USE_PRINTF
+        float scale = 1.0f;
+        for (uint8_t i = 0; i < decimals; i++) scale *= 10.0f;
+        dtostrf(value / scale, width, decimals, out); // Как было в showEditValue()
+        (void)pad;
+        return out + strlen(out);
+#else
+        bool negative = value < 0;
+        return number(out, negative ? -(uint16_t)value : (uint16_t)value, negative, decimals, width, pad);
+#endif
+    }
+
+    /*
+     * Температура из сотых долей градуса с одним знаком после точки
+     * Округление до десятых - от нуля (4.45 -> "4.5", -4.45 -> "-4.5")
+     */
+    static char* tempCenti(char* out, int16_t centi, uint8_t width = 0) {
+#if FORMAT_USE_PRINTF
+        // Как было в Display::showMainScreen(): без printf_flt выводит "?"
+        return out + snprintf(out, 8, "%*.1f", width, centi * 0.01f);
+#else
+        bool negative = centi < 0;
+        uint16_t magnitude = negative ? -(uint16_t)centi : (uint16_t)centi;
+        return number(out, (magnitude + 5) / 10, negative, 1, width, ' ');
+#endif
+    }
+
+private:
+    /*
+     * Общий вывод: модуль, знак, позиция точки, ширина поля
+     */
+    static char* number(char* out, uint16_t magnitude, bool negative, uint8_t decimals,
+                        uint8_t width, char pad) {
+        if (magnitude == 0) negative = false; // Без "-0.0" после округления
+        char digits[6]; // До 5 цифр uint16_t, в обратном порядке
+        uint8_t count = 0;
+        do {
+            digits[count++] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude != 0 || count <= decimals); // Ведущий ноль перед точкой
+
+        uint8_t length = count + (decimals ? 1 : 0) + (negative ? 1 : 0);
+        if (pad == '0' && negative) {
+            *out++ = '-'; // Знак перед нулями: "-04"
+            negative = false;
+        }
+        while (width > length) {
+            *out++ = pad;
+            width--;
+        }
+        if (negative) *out++ = '-';
+        while (count > 0) {
+            if (count == decimals) *out++ = '.';
+            *out++ = digits[--count];
+        }
+        *out = '\0';
+        return out;
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    Format() = delete;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+#include "EventQueue.h"
+
+/*
+ * Типы событий ввода
+ */
+enum InputEventType : uint8_t {
+    INPUT_BUTTON_CLICK,  // Кнопка нажата и отпущена до удержания (code - ButtonId)
+    INPUT_BUTTON_HOLD,   // Кнопка удерживается (code - ButtonId)
+    INPUT_BUTTON_REPEAT  // Автоповтор при удержании (code - ButtonId)
+};
+
+/*
+ * Событие ввода (4 байта)
+ */
+struct InputEvent {
+    uint8_t type;   // Тип события (InputEventType)
+    uint8_t code;   // Дополнительный код (зависит от типа)
+    uint16_t time;  // Момент события, младшие 16 бит SystemTimer::getMillis()
+};
+
+// Очередь событий ввода: прерывания пишут, главный цикл читает
+typedef EventQueue<InputEvent, 8> InputQueue;
@@ -0,0 +1,325 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/interrupt.h> // Для ISR()
+#include <util/atomic.h>   // Для ATOMIC_BLOCK
+#include <util/twi.h>      // Коды состояния TWI
+
+/*
+ * Драйвер символьного LCD 16x2 (HD44780) через расширитель PCF8574 по I2C
+ * Реализует:
+ * - Буфер кадра на 32 символа в RAM: запись строки - копирование в память
+ * - Теневую копию того, что сейчас показывает LCD, и вывод только
+ *   отличающихся символов (посимвольное сравнение кадра с копией)
+ * - Минимум перемещений курсора: команда установки адреса посылается,
+ *   только если следующий измененный символ не стоит под курсором
+ * - Вывод в фоне конечным автоматом на прерывании TWI:
+ *   одна транзакция I2C на все изменения, главный цикл не ждет шину
+ * - Прогресс вывода через flush() и счетчик переданных байтов шины
+ *
+ * Каждый байт для LCD передается в 4-битном режиме четырьмя байтами PCF8574
+ * (старшая и младшая тетрады, каждая со стробом EN). Перемещение курсора
+ * стоит столько же, сколько один символ, поэтому пропустить неизмененные
+ * символы командой адреса никогда не дороже, чем переписать их.
+ * Смена одной цифры температуры - 8 байт шины вместо 68 на строку.
+ *
+ * Прерывание TWI занято этим классом: библиотеку Wire использовать нельзя.
+ */
+class LcdDriver {
+public:
+    static const uint8_t COLS = 16;          // Символов в строке
+    static const uint8_t ROWS = 2;           // Строк
+    static const uint8_t CELLS = COLS * ROWS; // Размер буфера кадра
+    static const uint32_t I2C_CLOCK = 100000UL; // Частота шины I2C (Гц)
+
+    /*
+     * Инициализация шины и дисплея (блокирующая, только из setup())
+     * address - 7-битный адрес PCF8574 (обычно 0x27)
+     */
+    static void begin(uint8_t i2cAddress) {
+        address = i2cAddress;
+        PORTC |= _BV(4) | _BV(5); // Подтяжка SDA/SCL, как в Wire
+        TWSR = 0;                 // Предделитель 1
+        TWBR = ((F_CPU / I2C_CLOCK) - 16) / 2;
+        TWCR = _BV(TWEN);
+
+        // Инициализация HD44780 в 4-битном режиме (по даташиту)
+        delay(50);
+        writeNibbleBlocking(0x30);
+        delay(5);
+        writeNibbleBlocking(0x30);
+        delay(5);
+        writeNibbleBlocking(0x30);
+        delayMicroseconds(150);
+        writeNibbleBlocking(0x20);
+        writeCommandBlocking(0x28); // 4 бита, 2 строки, шрифт 5x8
+        writeCommandBlocking(0x0C); // Дисплей включен, курсора нет
+        writeCommandBlocking(0x01); // Очистка
+        delay(2);
+        writeCommandBlocking(0x06); // Сдвиг курсора вправо
+
+        // После очистки LCD показывает пробелы
+        memset(frame, ' ', sizeof(frame));
+        memset(shadow, ' ', sizeof(shadow));
+        cursor = 0;
+    }
+
+    /*
+     * Запись строки в буфер кадра
+     * text дополняется пробелами до 16 символов, лишнее отбрасывается.
+     * Символ, который автомат уже вывел, а затем изменили, будет выведен
+     * снова: автомат сравнивает кадр с теневой копией на каждом шаге.
+     */
+    static void setLine(uint8_t row, const char* text) {
+        if (row >= ROWS) return;
+        char* line = &frame[row * COLS];
+        for (uint8_t col = 0; col < COLS; col++) {
+            line[col] = *text ? *text++ : ' ';
+        }
+    }
+
+    /*
+     * Запуск фонового вывода изменений
+     * Возвращает количество символов, еще не выведенных на дисплей (0 - кадр выведен)
+     */
+    static uint8_t flush() {
+        uint8_t remaining = 0;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            for (uint8_t cell = 0; cell < CELLS; cell++) {
+                if (frame[cell] != shadow[cell]) remaining++;
+            }
+            if (!busy && remaining) startTransfer();
+        }
+        return remaining;
+    }
+
+    /*
+     * Количество байтов, переданных по шине с момента запуска (включая адрес)
+     */
+    static uint32_t getBytesSent() {
+        uint32_t result;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            result = bytesSent;
+        }
+        return result;
+    }
+
+    /*
+     * Идет ли сейчас обмен по шине
+     */
+    static bool isBusy() {
+        return busy;
+    }
+
+    /*
+     * Количество ошибок шины (нет ответа PCF8574, потеря арбитража)
+     */
+    static uint8_t getErrors() {
+        return errors;
+    }
+
+    /*
+     * Обработка прерывания TWI
+     * Вызывается только из ISR(TWI_vect)
+     */
+    static void onTwi() {
+        switch (TW_STATUS) {
+            case TW_START:
+            case TW_REP_START:
+                TWDR = (address << 1) | TW_WRITE;
+                bytesSent++;
+                TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+                break;
+
+            case TW_MT_SLA_ACK:
+            case TW_MT_DATA_ACK: {
+                uint8_t value;
+                if (nextBusByte(value)) {
+                    TWDR = value;
+                    bytesSent++;
+                    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+                } else {
+                    stop();
+                }
+                break;
+            }
+
+            default:
+                // Ошибка шины: символ, который выводился, будет выведен заново,
+                // положение курсора LCD неизвестно
+                if (errors < 0xFF) errors++;
+                if (sendingCell != NO_CELL) shadow[sendingCell] = 0;
+                sendingCell = NO_CELL;
+                cursor = NO_CELL;
+                dataPending = false;
+                phase = PHASE_IDLE;
+                rawLength = 0;
+                stop();
+                break;
+        }
+    }
+
+private:
+    // Биты PCF8574
+    static const uint8_t PCF_RS = 0x01;        // Регистр данных
+    static const uint8_t PCF_EN = 0x04;        // Строб
+    static const uint8_t PCF_BACKLIGHT = 0x08; // Подсветка
+    static const uint8_t NO_CELL = 0xFF;
+    static const uint8_t PHASE_IDLE = 4;       // Текущий байт LCD передан
+    static const uint8_t ROW_ADDRESS[ROWS];    // Адреса начала строк в DDRAM
+
+    static uint8_t address;            // Адрес PCF8574
+    static char frame[CELLS];          // Буфер кадра (что должно быть на экране)
+    static char shadow[CELLS];         // Теневая копия (что показывает LCD)
+    static volatile bool busy;         // Идет транзакция
+    static volatile uint8_t errors;    // Счетчик ошибок шины
+    static volatile uint32_t bytesSent; // Счетчик байтов шины
+
+    // Состояние автомата вывода (меняется только в прерывании, пока busy)
+    static uint8_t cursor;         // Позиция курсора LCD (ячейка) или NO_CELL
+    static uint8_t sendingCell;    // Выводимая ячейка или NO_CELL
+    static bool dataPending;       // После команды адреса нужно вывести символ
+    static uint8_t lcdByte;        // Текущий байт для LCD
+    static bool lcdData;           // Байт - данные (иначе команда)
+    static uint8_t phase;          // Тетрада/строб текущего байта (0..3)
+    static const uint8_t* rawData; // Готовые байты PCF8574 (инициализация)
+    static uint8_t rawLength;
+
+    /*
+     * Байт PCF8574 для фазы передачи байта LCD:
+     * 0 - старшая тетрада с EN, 1 - без EN, 2 - младшая с EN, 3 - без EN
+     */
+    static uint8_t busByte(uint8_t value, bool data, uint8_t step) {
+        uint8_t nibble = (step < 2) ? (value & 0xF0) : (uint8_t)(value << 4);
+        return nibble | PCF_BACKLIGHT | (data ? PCF_RS : 0) | ((step & 1) ? 0 : PCF_EN);
+    }
+
+    /*
+     * Поиск отличающейся ячейки, начиная с позиции курсора (по кругу)
+     */
+    static bool findChanged(uint8_t& cell) {
+        uint8_t start = (cursor == NO_CELL) ? 0 : cursor;
+        for (uint8_t n = 0; n < CELLS; n++) {
+            uint8_t i = start + n;
+            if (i >= CELLS) i -= CELLS;
+            if (frame[i] != shadow[i]) {
+                cell = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * Символ выводимой ячейки; курсор LCD сдвигается на следующую
+     */
+    static void emitData() {
+        char c = frame[sendingCell];
+        shadow[sendingCell] = c;
+        lcdByte = c;
+        lcdData = true;
+        cursor = sendingCell + 1;
+        // В конце строки адрес DDRAM уходит за видимую область
+        if (cursor % COLS == 0) cursor = NO_CELL;
+    }
+
+    /*
+     * Следующий байт для LCD: при необходимости адрес, затем символ
+     */
+    static bool nextLcdByte() {
+        if (dataPending) {
+            dataPending = false;
+            emitData();
+            return true;
+        }
+        uint8_t cell;
+        if (!findChanged(cell)) {
+            sendingCell = NO_CELL;
+            return false;
+        }
+        sendingCell = cell;
+        if (cell != cursor) {
+            // Установка адреса DDRAM
+            lcdByte = 0x80 | (ROW_ADDRESS[cell / COLS] + cell % COLS);
+            lcdData = false;
+            dataPending = true;
+            return true;
+        }
+        emitData();
+        return true;
+    }
+
+    /*
+     * Следующий байт для шины; false - передавать больше нечего
+     */
+    static bool nextBusByte(uint8_t& value) {
+        if (rawLength) {
+            value = *rawData++;
+            rawLength--;
+            return true;
+        }
+        if (phase == PHASE_IDLE) {
+            if (!nextLcdByte()) return false;
+            phase = 0;
+        }
+        value = busByte(lcdByte, lcdData, phase++);
+        return true;
+    }
+
+    static void startTransfer() {
+        while (TWCR & _BV(TWSTO)); // Предыдущий STOP еще формируется
+        busy = true;
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA);
+    }
+
+    static void stop() {
+        TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+        busy = false;
+    }
+
+    /*
+     * Блокирующая передача готовых байтов PCF8574 (только для инициализации)
+     */
+    static void writeRawBlocking(const uint8_t* data, uint8_t length) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            rawData = data;
+            rawLength = length;
+            startTransfer();
+        }
+        while (busy);
+    }
+
+    static void writeNibbleBlocking(uint8_t nibble) {
+        uint8_t data[2] = { busByte(nibble, false, 0), busByte(nibble, false, 1) };
+        writeRawBlocking(data, sizeof(data));
+    }
+
+    static void writeCommandBlocking(uint8_t command) {
+        uint8_t data[4];
+        for (uint8_t step = 0; step < 4; step++) data[step] = busByte(command, false, step);
+        writeRawBlocking(data, sizeof(data));
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    LcdDriver() = delete;
+};
+
+const uint8_t LcdDriver::ROW_ADDRESS[ROWS] = {0x00, 0x40};
+uint8_t LcdDriver::address = 0x27;
+char LcdDriver::frame[CELLS];
+char LcdDriver::shadow[CELLS];
+volatile bool LcdDriver::busy = false;
+volatile uint8_t LcdDriver::errors = 0;
+volatile uint32_t LcdDriver::bytesSent = 0;
+uint8_t LcdDriver::cursor = LcdDriver::NO_CELL;
+uint8_t LcdDriver::sendingCell = LcdDriver::NO_CELL;
+bool LcdDriver::dataPending = false;
+uint8_t LcdDriver::lcdByte = 0;
+bool LcdDriver::lcdData = false;
+uint8_t LcdDriver::phase = LcdDriver::PHASE_IDLE;
+const uint8_t* LcdDriver::rawData = nullptr;
+uint8_t LcdDriver::rawLength = 0;
+
+// Прерывание TWI: очередной шаг транзакции вывода на LCD
+ISR(TWI_vect) {
+    LcdDriver::onTwi();
+}
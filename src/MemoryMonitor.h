@@ -0,0 +1,101 @@
+#pragma once
+#include <Arduino.h>
+#include <util/atomic.h> // Для ATOMIC_BLOCK
+
+/*
+ * Контроль свободной RAM
+ * Реализует:
+ * - Закраску свободной памяти между концом .bss и вершиной стека шаблоном
+ *   до запуска конструкторов (секция .init3)
+ * - Минимум свободной памяти за все время работы: самый глубокий
+ *   заход стека находится по первому затертому байту шаблона
+ * - Текущий запас между кучей и указателем стека
+ * - Контроль политики "только статическая память": любое обращение
+ *   к malloc/new сдвигает __brkval и видно в отчете как занятая куча
+ *
+ * Поиск минимума просматривает всю свободную память (около 1.5 КБ),
+ * поэтому вызывается по запросу (консоль, экран диагностики), а не в цикле.
+ */
+extern uint8_t _end;         // Конец .bss (начало кучи), из компоновщика
+extern uint8_t __stack;      // Вершина стека (RAMEND)
+extern uint8_t __heap_start; // Начало кучи
+extern char* __brkval;       // Конец занятой кучи (0 - malloc не вызывался)
+
+class MemoryMonitor {
+public:
+    static const uint8_t PAINT = 0xA5;            // Шаблон закраски
+    static const uint16_t MIN_FREE_BUDGET = 256;  // Допустимый минимум свободной RAM (байт)
+
+    /*
+     * Закраска свободной памяти (вызывается кодом запуска из .init3, не из программы)
+     * В .init3 стек еще пуст, а .data и .bss инициализируются позже.
+     * Только встраивание: адрес возврата из вызова был бы затерт закраской
+     */
+    __attribute__((always_inline)) static inline void paint() {
+        uint8_t* p = &_end;
+        while (p <= &__stack) *p++ = PAINT;
+    }
+
+    /*
+     * Минимум свободной памяти с момента запуска (байт)
+     * Считается от конца кучи до первого байта, затертого стеком
+     */
+    static uint16_t getMinFree() {
+        const uint8_t* p = heapEnd();
+        const uint8_t* top = (const uint8_t*)SP;
+        uint16_t count = 0;
+        while (p <= top && *p == PAINT) {
+            p++;
+            count++;
+        }
+        return count;
+    }
+
+    /*
+     * Свободная память сейчас: между концом кучи и указателем стека (байт)
+     */
+    static uint16_t getFreeNow() {
+        uint16_t sp;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            sp = SP;
+        }
+        return sp - (uint16_t)(uintptr_t)heapEnd();
+    }
+
+    /*
+     * Занятая куча (байт); по политике прошивки должна быть 0
+     */
+    static uint16_t getHeapUsed() {
+        return __brkval ? (uint16_t)(__brkval - (char*)&__heap_start) : 0;
+    }
+
+    /*
+     * Отчет в Serial
+     */
+    static void printReport(Print& out) {
+        out.print(F("ram free min: "));
+        out.print(getMinFree());
+        out.print(F(" now: "));
+        out.print(getFreeNow());
+        out.print(F(" heap: "));
+        out.print(getHeapUsed());
+        // Выход за бюджет памяти или использование кучи - повод проверить релиз
+        if (getMinFree() < MIN_FREE_BUDGET || getHeapUsed() != 0) out.print(F(" OVER BUDGET"));
+        out.println();
+    }
+
+private:
+    static const uint8_t* heapEnd() {
+        return __brkval ? (const uint8_t*)__brkval : &__heap_start;
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    MemoryMonitor() = delete;
+};
+
+// Закраска до инициализации .data/.bss и конструкторов: функция встраивается
+// в код запуска, поэтому naked и без возврата
+void memoryMonitorPaint() __attribute__((naked, used, section(".init3")));
+void memoryMonitorPaint() {
+    MemoryMonitor::paint();
+}
@@ -1,5 +1,6 @@
 #pragma once
-#include "EEPROMStorage.h"
+#include "SettingsStore.h"
+#include "OutputBank.h"
 #include <Arduino.h>
 
 /*
@@ -9,7 +10,6 @@ struct MixerSettings {
     uint8_t mode = 1;         // Режим работы (0-выкл, 1-авто (с компрессором), 2-таймер)
     uint16_t workTime = 60;   // Время работы в таймерном режиме (сек)
     uint16_t idleTime = 180;  // Время простоя в таймерном режиме (сек)
-    uint8_t checksum = 0;     // Контрольная сумма
 } __attribute__((packed));
 
 /*
@@ -17,33 +17,21 @@ struct MixerSettings {
  */
 class MixerController {
 private:
-    const uint8_t mixerPin;
+    OutputBank& outputs;
     MixerSettings settings;
     bool mixerState = false;
+    bool manual = false;              // Ручное управление (тестовое меню), автоматика приостановлена
     unsigned long lastSwitchTime = 0; // Время последнего изменения состояния миксера
 
-    /*
-     * Расчет контрольной суммы
-     */
-    uint8_t calculateChecksum() const {
-        uint8_t sum = 0;
-        const uint8_t* p = reinterpret_cast<const uint8_t*>(&settings);
-        for(size_t i = 0; i < sizeof(settings) - 1; i++) {
-            sum += p[i];
-        }
-        return ~sum; // Инвертированная сумма
-    }
-
 public:
     /*
      * Конструктор
-     * pin - пин управления миксером
+     * outputsRef - банк выходов (миксер - OUT_MIXER)
      */
-    MixerController(uint8_t pin) 
-        : mixerPin(pin)
+    MixerController(OutputBank& outputsRef) 
+        : outputs(outputsRef)
     {
-        pinMode(pin, OUTPUT);
-        digitalWrite(pin, LOW); // Миксер выключен по умолчанию
+        // Миксер выключен по умолчанию (OutputBank выключает все выходы)
     }
 
     /*
@@ -51,6 +39,8 @@ public:
      * compressorRunning - состояние компрессора (для режима авто)
      */
     void update(bool compressorRunning) {
+        if (manual) return; // Миксером управляет тестовое меню
+
         unsigned long currentMillis = millis();
         unsigned long elapsed = currentMillis - lastSwitchTime;
         
@@ -89,7 +79,7 @@ public:
      */
     void start() {
         if (!mixerState) { // Включаем только если он выключен
-            digitalWrite(mixerPin, HIGH);
+            outputs.set(OUT_MIXER, true);
             mixerState = true;
             lastSwitchTime = millis(); // Запоминаем время включения
         }
@@ -100,12 +90,19 @@ public:
      */
     void stop() {
         if (mixerState) { // Выключаем только если он включен
-            digitalWrite(mixerPin, LOW);
+            outputs.set(OUT_MIXER, false);
             mixerState = false;
             lastSwitchTime = millis(); // Запоминаем время выключения
         }
     }
 
+    /*
+     * Ручное управление: пока включено, update() не меняет состояние миксера
+     */
+    void setManual(bool on) {
+        manual = on;
+    }
+
     /*
      * Установка состояния миксера (для тестирования)
      * state - true для включения, false для выключения
@@ -119,28 +116,25 @@ public:
     }
 
     /*
-     * Загрузка настроек из EEPROM
-     * Возвращает true, если настройки загружены успешно и контрольная сумма верна
+     * Сброс настроек к значениям по умолчанию (из SettingsStore)
      */
-    bool loadSettings() {
-        // Адрес начала настроек миксера (после настроек компрессора)
-        constexpr int address = sizeof(CoolerSettings); 
-        EEPROMStorage::read(address, settings);
-        // Если контрольная сумма не совпадает, сбрасываем к настройкам по умолчанию
-        if(settings.checksum != calculateChecksum()) {
-            settings = MixerSettings(); // Инициализация дефолтными значениями
-            return false;
-        }
-        return true;
+    void resetSettings() {
+        settings = MixerSettings();
+    }
+
+    /*
+     * Проверка загруженных настроек (из SettingsStore)
+     * Возвращает false, если значения недопустимы
+     */
+    bool applySettings() const {
+        return settings.mode <= 2;
     }
 
     /*
      * Сохранение настроек в EEPROM
      */
     void saveSettings() {
-        settings.checksum = calculateChecksum(); // Обновляем контрольную сумму перед сохранением
-        constexpr int address = sizeof(CoolerSettings);
-        EEPROMStorage::write(address, settings);
+        SettingsStore::save(SETTINGS_MIXER);
     }
 
     /*
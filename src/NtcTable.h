@@ -0,0 +1,104 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h> // Для PROGMEM и pgm_read_word
+#include "AdcSampler.h"   // Разрядность кода АЦП
+
+/*
+ * Таблица пересчета кода АЦП в температуру для NTC-термистора
+ * Реализует:
+ * - Генерацию таблицы на этапе компиляции (constexpr) по R и B термистора
+ * - Хранение таблицы во флеш-памяти (PROGMEM), 129 точек по 2 байта
+ * - Линейную интерполяцию между точками без операций с плавающей точкой
+ *
+ * Схема включения та же, что и у GyverNTC: термистор к GND, резистор R к VCC.
+ * Результат - температура в сотых долях градуса (centi-°C).
+ * Ошибка интерполяции для R = 10 кОм, B = 3950 (моделирование по всем кодам):
+ * до 0.02 °C в диапазоне -15..75 °C и до 0.04 °C в 75..90 °C. При 64 кодах
+ * на отрезок на горячем конце она доходила до 0.16 °C.
+ *
+ * Параметры шаблона:
+ * R   - сопротивление резистора делителя (Ом)
+ * B   - B-коэффициент термистора
+ * RT  - сопротивление термистора при базовой температуре (Ом)
+ * T0  - базовая температура (°C)
+ */
+template <uint32_t R, uint16_t B, uint32_t RT = 10000, int8_t T0 = 25>
+class NtcTable {
+public:
+    static const uint8_t INPUT_BITS = AdcSampler::RESULT_BITS;       // Разрядность входного кода
+    static const uint8_t STEP_BITS = 5;                               // 32 кода на отрезок
+    static const uint16_t POINTS = (1 << (INPUT_BITS - STEP_BITS)) + 1;
+    static const int16_t TEMP_MIN = -30000;                           // Ограничение снизу (обрыв)
+    static const int16_t TEMP_MAX = 30000;                            // Ограничение сверху (КЗ)
+
+    /*
+     * Пересчет кода АЦП в температуру
+     * code - код АЦП разрядностью INPUT_BITS
+     * Возвращает температуру в сотых долях градуса
+     */
+    static int16_t convert(uint16_t code) {
+        uint8_t index = code >> STEP_BITS;
+        uint8_t frac = code & ((1 << STEP_BITS) - 1);
+        int16_t a = pgm_read_word(&table.points[index]);
+        int16_t b = pgm_read_word(&table.points[index + 1]);
+        // Умножение 16x8 бит и сдвиг вместо деления
+        return a + (int16_t)(((int32_t)(int16_t)(b - a) * frac) >> STEP_BITS);
+    }
+
+private:
+    struct Points {
+        int16_t points[POINTS];
+    };
+
+    // Максимальный код в шкале GyverNTC (1023), приведенный к разрядности входа
+    static constexpr float CODE_MAX = 1023.0f * (1 << (INPUT_BITS - 10));
+
+    /*
+     * Натуральный логарифм, вычисляемый при компиляции
+     * x приводится к диапазону [1, 2), далее ряд ln(x) = 2*atanh((x-1)/(x+1))
+     */
+    static constexpr float ln(float x) {
+        int8_t k = 0;
+        while (x >= 2.0f) { x *= 0.5f; k++; }
+        while (x < 1.0f) { x *= 2.0f; k--; }
+        float y = (x - 1.0f) / (x + 1.0f);
+        float y2 = y * y;
+        float term = y;
+        float sum = 0.0f;
+        for (uint8_t n = 1; n < 30; n += 2) {
+            sum += term / n;
+            term *= y2;
+        }
+        return 2.0f * sum + k * 0.69314718f;
+    }
+
+    /*
+     * Температура в точке таблицы по B-уравнению (та же формула, что в GyverNTC)
+     */
+    static constexpr int16_t point(uint16_t i) {
+        float code = (float)((uint32_t)i << STEP_BITS);
+        if (code <= 0.0f) return TEMP_MAX;      // Сопротивление 0 - короткое замыкание
+        if (code >= CODE_MAX) return TEMP_MIN;  // Бесконечное сопротивление - обрыв
+        float rNtc = R / (CODE_MAX / code - 1.0f);
+        float invT = ln(rNtc / RT) / B + 1.0f / (T0 + 273.15f);
+        if (invT <= 0.0f) return TEMP_MAX;
+        float centi = (1.0f / invT - 273.15f) * 100.0f;
+        if (centi >= TEMP_MAX) return TEMP_MAX;
+        if (centi <= TEMP_MIN) return TEMP_MIN;
+        return (int16_t)(centi + (centi >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    static constexpr Points build() {
+        Points result{};
+        for (uint16_t i = 0; i < POINTS; i++) {
+            result.points[i] = point(i);
+        }
+        return result;
+    }
+
+    // Таблица вычисляется компилятором и целиком размещается во флеш-памяти
+    static constexpr Points table PROGMEM = build();
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    NtcTable() = delete;
+};
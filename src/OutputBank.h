@@ -0,0 +1,274 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h> // Для PROGMEM и pgm_read_byte
+#include "Pins.h"
+
+/*
+ * Исполнительные устройства (биты вектора состояния выходов)
+ */
+enum Output : uint8_t {
+    OUT_COMPRESSOR  = 0x01, // Компрессор
+    OUT_MIXER       = 0x02, // Мешалка
+    OUT_DRAIN_VALVE = 0x04, // Клапан слива
+    OUT_COLD_WATER  = 0x08, // Клапан холодной воды
+    OUT_HOT_WATER   = 0x10, // Клапан горячей воды
+    OUT_WASH_PUMP   = 0x20, // Моющий насос
+    OUT_ALKALI_PUMP = 0x40, // Насос щелочи
+    OUT_ACID_PUMP   = 0x80  // Насос кислоты
+};
+
+// Все выходы системы мойки
+#define OUT_WASH_GROUP (OUT_DRAIN_VALVE | OUT_COLD_WATER | OUT_HOT_WATER | \
+                        OUT_WASH_PUMP | OUT_ALKALI_PUMP | OUT_ACID_PUMP)
+
+/*
+ * Таблица блокировок: пары выходов, которые не могут быть включены одновременно
+ * Проверяется на этапе компиляции для шагов встроенных рецептов (Recipe.h)
+ * и при каждом изменении выходов в OutputBank
+ */
+struct Interlock {
+    static constexpr uint8_t PAIRS[] = {
+        OUT_ALKALI_PUMP | OUT_ACID_PUMP,  // Щелочь и кислота не смешиваются
+        OUT_COMPRESSOR | OUT_HOT_WATER    // Горячая вода не подается в охлаждаемый танк
+    };
+    // Выход пары, который побеждает всегда; 0 - остается уже включенный
+    static constexpr uint8_t WINNERS[] = {
+        0,
+        OUT_HOT_WATER // Шаг мойки не пропускается: компрессор ждет конца ополаскивания
+    };
+    static const uint8_t PAIR_COUNT = sizeof(PAIRS);
+    static_assert(sizeof(WINNERS) == PAIR_COUNT, "Interlock: one winner entry per pair");
+
+    /*
+     * Выходы нарушенных пар (0 - вектор состояния допустим)
+     * Цикл разворачивается компилятором: по паре AND и сравнение на каждую пару
+     */
+    static constexpr uint8_t conflicts(uint8_t state) {
+        uint8_t result = 0;
+        for (uint8_t i = 0; i < PAIR_COUNT; i++) {
+            if ((state & PAIRS[i]) == PAIRS[i]) result |= PAIRS[i];
+        }
+        return result;
+    }
+
+    /*
+     * Выходы, которые можно включить из запроса requested при текущем состоянии current
+     * В нарушенной паре остается победитель из WINNERS, иначе уже включенный выход;
+     * если оба выхода пары новые - удерживаются оба
+     */
+    static constexpr uint8_t allowed(uint8_t requested, uint8_t current) {
+        uint8_t result = requested;
+        for (uint8_t i = 0; i < PAIR_COUNT; i++) {
+            uint8_t pair = PAIRS[i];
+            if ((result & pair) != pair) continue;
+            uint8_t hold = WINNERS[i] ? (pair & ~WINNERS[i]) : (pair & ~current);
+            result &= ~(hold ? hold : pair);
+        }
+        return result;
+    }
+};
+
+// Горячее ополаскивание при работающем компрессоре: вода подается, компрессор удерживается
+static_assert(Interlock::allowed(OUT_COMPRESSOR | OUT_DRAIN_VALVE | OUT_HOT_WATER, OUT_COMPRESSOR) ==
+              (OUT_DRAIN_VALVE | OUT_HOT_WATER), "Interlock: hot rinse must win over the compressor");
+// Компрессор не включается во время горячего ополаскивания
+static_assert(Interlock::allowed(OUT_COMPRESSOR | OUT_HOT_WATER, OUT_HOT_WATER) == OUT_HOT_WATER,
+              "Interlock: compressor must wait for the hot rinse");
+// Кислота не включается поверх щелочи
+static_assert(Interlock::allowed(OUT_ALKALI_PUMP | OUT_ACID_PUMP, OUT_ALKALI_PUMP) == OUT_ALKALI_PUMP,
+              "Interlock: already-on pump must win");
+
+/*
+ * Отображение выходов на порты микроконтроллера
+ * Все вычисляется на этапе компиляции по пинам из Pins.h
+ */
+struct OutputPinMap {
+    enum Port : uint8_t { PORT_IDX_B, PORT_IDX_C, PORT_IDX_D, PORT_IDX_COUNT };
+
+    // Пины в порядке битов Output
+    static constexpr uint8_t PINS[8] = {
+        COMPRESSOR_PIN, MIXER_PIN, DRAIN_VALVE_PIN, COLD_WATER_VALVE_PIN,
+        HOT_WATER_VALVE_PIN, WASH_PUMP_PIN, ALKALI_PUMP_PIN, ACID_PUMP_PIN
+    };
+
+    // Порт и бит вывода Arduino Nano: D0-D7 - PORTD, D8-D13 - PORTB, A0-A5 - PORTC
+    static constexpr uint8_t portOf(uint8_t pin) {
+        return pin < 8 ? PORT_IDX_D : (pin < 14 ? PORT_IDX_B : PORT_IDX_C);
+    }
+    static constexpr uint8_t bitOf(uint8_t pin) {
+        return pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14);
+    }
+
+    /*
+     * Биты порта, соответствующие вектору состояния
+     */
+    static constexpr uint8_t portBits(uint8_t port, uint8_t state) {
+        uint8_t bits = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            if ((state & (1 << i)) && portOf(PINS[i]) == port) {
+                bits |= 1 << bitOf(PINS[i]);
+            }
+        }
+        return bits;
+    }
+
+    /*
+     * Таблица перевода вектора состояния в биты портов по полубайтам:
+     * bits[port][n] - младший полубайт n, bits[port][16 + n] - старший
+     */
+    struct Lookup {
+        uint8_t bits[PORT_IDX_COUNT][32];
+    };
+
+    static constexpr Lookup buildLookup() {
+        Lookup result{};
+        for (uint8_t port = 0; port < PORT_IDX_COUNT; port++) {
+            for (uint8_t n = 0; n < 16; n++) {
+                result.bits[port][n] = portBits(port, n);
+                result.bits[port][16 + n] = portBits(port, n << 4);
+            }
+        }
+        return result;
+    }
+};
+
+/*
+ * Банк выходов
+ * Реализует:
+ * - Отображение пинов из Pins.h на маски PORTB/PORTC/PORTD на этапе компиляции
+ * - Применение всего вектора состояния одной атомарной записью на порт
+ *
+ * - Блокировки по таблице Interlock: выход, включение которого нарушило бы
+ *   пару, удерживается выключенным, пока включен второй выход пары
+ *   (если оба запрошены одновременно - удерживаются оба). Для пар с победителем
+ *   (горячая вода и компрессор) удерживается всегда проигравший выход.
+ *   Запрос сохраняется, и выход включится сам, когда блокировка снимется.
+ *
+ * Все контроллеры управляют выходами только через этот класс, поэтому смена
+ * комбинации клапанов и насосов происходит без промежуточных состояний
+ * (раньше, например, слив успевал закрыться до открытия новой комбинации).
+ */
+class OutputBank {
+private:
+    // Маски выходов в каждом порту
+    static constexpr uint8_t MASK_B = OutputPinMap::portBits(OutputPinMap::PORT_IDX_B, 0xFF);
+    static constexpr uint8_t MASK_C = OutputPinMap::portBits(OutputPinMap::PORT_IDX_C, 0xFF);
+    static constexpr uint8_t MASK_D = OutputPinMap::portBits(OutputPinMap::PORT_IDX_D, 0xFF);
+
+    static_assert(MASK_C < _BV(6), "OutputBank: A6/A7 are analog-only and cannot be outputs");
+
+    // Таблица перевода во флеш-памяти
+    static constexpr OutputPinMap::Lookup lookup PROGMEM = OutputPinMap::buildLookup();
+
+    static uint8_t translate(uint8_t port, uint8_t state) {
+        return pgm_read_byte(&lookup.bits[port][state & 0x0F]) |
+               pgm_read_byte(&lookup.bits[port][16 + (state >> 4)]);
+    }
+
+    volatile uint8_t state;      // Текущий вектор состояния (биты Output)
+    volatile uint8_t requested;  // Запрошенный контроллерами вектор (до блокировок)
+    volatile uint8_t held;       // Запрошенные, но удерживаемые блокировкой выходы
+    volatile uint8_t violations; // Впервые удержанные выходы, еще не записанные в журнал
+
+    /*
+     * Применение запроса с учетом блокировок (прерывания должны быть запрещены)
+     * Без нарушений - несколько тактов на пару таблицы Interlock
+     */
+    void resolve(uint8_t newRequested) {
+        requested = newRequested;
+        uint8_t newState = newRequested;
+        if (Interlock::conflicts(newState)) newState = Interlock::allowed(newRequested, state);
+        uint8_t newHeld = newRequested & ~newState;
+        violations |= newHeld & ~held;
+        held = newHeld;
+        commit(newState);
+    }
+
+    /*
+     * Запись вектора состояния в порты (прерывания должны быть запрещены)
+     */
+    void commit(uint8_t newState) {
+        uint8_t b = translate(OutputPinMap::PORT_IDX_B, newState);
+        uint8_t c = translate(OutputPinMap::PORT_IDX_C, newState);
+        uint8_t d = translate(OutputPinMap::PORT_IDX_D, newState);
+        if (MASK_B) PORTB = (PORTB & ~MASK_B) | b;
+        if (MASK_C) PORTC = (PORTC & ~MASK_C) | c;
+        if (MASK_D) PORTD = (PORTD & ~MASK_D) | d;
+        state = newState;
+    }
+
+public:
+    /*
+     * Конструктор
+     * Настраивает все выходы и выключает их одной записью на порт
+     */
+    OutputBank() : state(0), requested(0), held(0), violations(0) {
+        uint8_t sreg = SREG;
+        cli();
+        if (MASK_B) { PORTB &= ~MASK_B; DDRB |= MASK_B; }
+        if (MASK_C) { PORTC &= ~MASK_C; DDRC |= MASK_C; }
+        if (MASK_D) { PORTD &= ~MASK_D; DDRD |= MASK_D; }
+        SREG = sreg;
+    }
+
+    /*
+     * Применение полного вектора состояния
+     * newState - биты Output; все порты обновляются при запрещенных прерываниях
+     */
+    void write(uint8_t newState) {
+        apply(0xFF, newState);
+    }
+
+    /*
+     * Замена группы выходов
+     * mask - изменяемые выходы, bits - их новое состояние
+     * Безопасно для вызова из прерываний: чтение-изменение-запись атомарны
+     */
+    void apply(uint8_t mask, uint8_t bits) {
+        uint8_t sreg = SREG;
+        cli();
+        resolve((requested & ~mask) | (bits & mask));
+        SREG = sreg;
+    }
+
+    /*
+     * Включение или выключение отдельных выходов
+     */
+    void set(uint8_t outputs, bool on) {
+        apply(outputs, on ? outputs : 0);
+    }
+
+    /*
+     * Текущий вектор состояния
+     */
+    uint8_t getState() const {
+        return state;
+    }
+
+    /*
+     * Проверка, включен ли выход
+     */
+    bool isOn(uint8_t output) const {
+        return (state & output) != 0;
+    }
+
+    /*
+     * Выходы, запрошенные контроллерами, но удерживаемые блокировкой
+     */
+    uint8_t getHeld() const {
+        return held;
+    }
+
+    /*
+     * Выходы, впервые удержанные блокировкой с прошлого вызова (для журнала событий)
+     * Маска сбрасывается; вызывать из главного цикла
+     */
+    uint8_t takeViolations() {
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t result = violations;
+        violations = 0;
+        SREG = sreg;
+        return result;
+    }
+};
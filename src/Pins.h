@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h> // Для A0-A7
+
+// Определение пинов подключения
+#define TANK_TOP_PROBE_PIN A0    // Датчик верха танка
+#define TANK_BOTTOM_PROBE_PIN A2 // Датчик низа танка
+#define WASH_RETURN_PROBE_PIN A3 // Датчик обратной линии мойки
+#define AMBIENT_PROBE_PIN A6     // Датчик окружающего воздуха
+#define COMPRESSOR_PIN 8
+#define MIXER_PIN 7
+#define WASH_BUTTON_PIN 2 // Пин для кнопки запуска мойки
+#define UP_BUTTON_PIN 3
+#define DOWN_BUTTON_PIN 4
+#define SET_BUTTON_PIN 6
+#define ESC_BUTTON_PIN 5
+#define DRAIN_VALVE_PIN 9
+#define COLD_WATER_VALVE_PIN 10
+#define HOT_WATER_VALVE_PIN 11
+#define WASH_PUMP_PIN 12
+#define ALKALI_PUMP_PIN 13
+#define ACID_PUMP_PIN A1
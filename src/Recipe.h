@@ -0,0 +1,164 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h> // Для PROGMEM
+#include "OutputBank.h"   // Биты выходов OUT_*
+
+/*
+ * Рецепты мойки (CIP)
+ * Реализует:
+ * - Компактный формат шага: выходы, длительность, условие по температуре, таймаут
+ * - Встроенные рецепты во флеш-памяти (PROGMEM)
+ * - Пользовательский рецепт в EEPROM (хранится в WashingSettings)
+ * - Проверку шагов встроенных рецептов по таблице блокировок Interlock
+ *   на этапе компиляции (пользовательский рецепт проверяет OutputBank)
+ *
+ * Шаг с условием по температуре сначала ждет, пока температура в обратной
+ * линии не достигнет minTemp, и только потом начинает отсчет длительности.
+ * Если задан timeout и температура не достигнута за это время, шаг
+ * завершается досрочно, а мойка помечается как выполненная с ошибкой.
+ */
+
+#define RECIPE_MAX_STEPS 8        // Максимум шагов пользовательского рецепта
+#define RECIPE_NO_TEMP INT8_MIN   // Шаг без условия по температуре
+#define RECIPE_DEFAULT_TIMEOUT 600 // Таймаут, назначаемый при включении условия по температуре (сек)
+
+/*
+ * Названия шагов (индекс в таблице stepNames)
+ */
+enum StepName : uint8_t {
+    STEP_IDLE,
+    STEP_COLD_RINSE,
+    STEP_ALKALI_WASH,
+    STEP_INTERM_RINSE,
+    STEP_ACID_WASH,
+    STEP_FINAL_RINSE,
+    STEP_HOT_RINSE,
+    STEP_NAME_COUNT
+};
+
+/*
+ * Шаг рецепта (7 байт)
+ * Шаг с условием по температуре всегда имеет таймаут: иначе при неисправном
+ * датчике обратной линии мойка ждала бы бесконечно
+ */
+struct RecipeStep {
+    uint8_t name;       // Название шага (StepName)
+    uint8_t outputs;    // Включенные выходы (биты OUT_* из OUT_WASH_GROUP)
+    uint16_t duration;  // Длительность шага (сек)
+    int8_t minTemp;     // Мин. температура обратной линии (°C) или RECIPE_NO_TEMP
+    uint16_t timeout;   // Макс. ожидание температуры (сек), 0 - без ограничения
+} __attribute__((packed));
+
+/*
+ * Встроенные и пользовательский рецепты
+ */
+enum RecipeId : uint8_t {
+    RECIPE_FULL_CIP,    // Полная мойка: щелочь и кислота
+    RECIPE_QUICK_RINSE, // Быстрое ополаскивание
+    RECIPE_ACID_ONLY,   // Только кислотная мойка
+    RECIPE_CUSTOM,      // Пользовательский рецепт из EEPROM
+    RECIPE_RINSE_OUT,   // Служебный: вымывание химии после прерванной мойки
+    RECIPE_COUNT
+};
+
+/*
+ * Описание встроенного рецепта во флеш-памяти
+ */
+struct RecipeInfo {
+    const char* name;          // Название (PROGMEM)
+    const RecipeStep* steps;   // Шаги (PROGMEM)
+    uint8_t stepCount;         // Количество шагов
+};
+
+// Названия шагов в PROGMEM
+const char stepNameIdle[] PROGMEM = "IDLE";
+const char stepNameColdRinse[] PROGMEM = "COLD RINSE";
+const char stepNameAlkaliWash[] PROGMEM = "ALKALI WASH";
+const char stepNameIntermRinse[] PROGMEM = "INTERM. RINSE";
+const char stepNameAcidWash[] PROGMEM = "ACID WASH";
+const char stepNameFinalRinse[] PROGMEM = "FINAL RINSE";
+const char stepNameHotRinse[] PROGMEM = "HOT RINSE";
+
+const char* const stepNames[STEP_NAME_COUNT] PROGMEM = {
+    stepNameIdle, stepNameColdRinse, stepNameAlkaliWash, stepNameIntermRinse,
+    stepNameAcidWash, stepNameFinalRinse, stepNameHotRinse
+};
+
+// Полная мойка: те же этапы и времена, что раньше были зашиты в WashingController
+constexpr RecipeStep recipeFullCip[] PROGMEM = {
+    {STEP_COLD_RINSE,   OUT_DRAIN_VALVE | OUT_COLD_WATER,  60,  RECIPE_NO_TEMP, 0},
+    {STEP_ALKALI_WASH,  OUT_ALKALI_PUMP | OUT_WASH_PUMP,   120, RECIPE_NO_TEMP, 0},
+    {STEP_INTERM_RINSE, OUT_DRAIN_VALVE | OUT_HOT_WATER,   60,  RECIPE_NO_TEMP, 0},
+    {STEP_ACID_WASH,    OUT_ACID_PUMP | OUT_WASH_PUMP,     120, RECIPE_NO_TEMP, 0},
+    {STEP_FINAL_RINSE,  OUT_DRAIN_VALVE | OUT_HOT_WATER,   60,  RECIPE_NO_TEMP, 0}
+};
+
+// Быстрое ополаскивание холодной и горячей водой
+constexpr RecipeStep recipeQuickRinse[] PROGMEM = {
+    {STEP_COLD_RINSE,   OUT_DRAIN_VALVE | OUT_COLD_WATER,  60,  RECIPE_NO_TEMP, 0},
+    {STEP_HOT_RINSE,    OUT_DRAIN_VALVE | OUT_HOT_WATER,   60,  RECIPE_NO_TEMP, 0}
+};
+
+// Только кислотная мойка: раствор должен прогреться до 35°C за 5 минут
+constexpr RecipeStep recipeAcidOnly[] PROGMEM = {
+    {STEP_COLD_RINSE,   OUT_DRAIN_VALVE | OUT_COLD_WATER,  60,  RECIPE_NO_TEMP, 0},
+    {STEP_ACID_WASH,    OUT_ACID_PUMP | OUT_WASH_PUMP,     120, 35,             300},
+    {STEP_FINAL_RINSE,  OUT_DRAIN_VALVE | OUT_HOT_WATER,   60,  RECIPE_NO_TEMP, 0}
+};
+
+// Вымывание остатков химии после прерванной мойки: длительные ополаскивания со сливом
+constexpr RecipeStep recipeRinseOut[] PROGMEM = {
+    {STEP_COLD_RINSE,   OUT_DRAIN_VALVE | OUT_COLD_WATER,  120, RECIPE_NO_TEMP, 0},
+    {STEP_HOT_RINSE,    OUT_DRAIN_VALVE | OUT_HOT_WATER,   120, RECIPE_NO_TEMP, 0},
+    {STEP_FINAL_RINSE,  OUT_DRAIN_VALVE | OUT_COLD_WATER,  60,  RECIPE_NO_TEMP, 0}
+};
+
+/*
+ * Проверка шагов встроенных рецептов на этапе компиляции
+ */
+struct RecipeCheck {
+    // Только выходы мойки, ни одной пары из таблицы Interlock, и шаг целиком
+    // включается при работающих компрессоре и мешалке (блокировка не пропустит шаг)
+    template <size_t N>
+    static constexpr bool valid(const RecipeStep (&steps)[N]) {
+        constexpr uint8_t cooling = OUT_COMPRESSOR | OUT_MIXER;
+        for (size_t i = 0; i < N; i++) {
+            uint8_t outputs = steps[i].outputs;
+            if ((outputs & ~OUT_WASH_GROUP) != 0) return false;
+            if (Interlock::conflicts(outputs) != 0) return false;
+            if ((Interlock::allowed(outputs | cooling, cooling) & outputs) != outputs) return false;
+            if (!stepValid(steps[i])) return false;
+        }
+        return true;
+    }
+
+    // Поля шага, общие для встроенных и пользовательского рецептов (и для
+    // проверки загруженного из EEPROM): длительность, название, таймаут температуры
+    static constexpr bool stepValid(const RecipeStep& step) {
+        return step.duration != 0 && step.name != STEP_IDLE && step.name < STEP_NAME_COUNT &&
+               (step.minTemp == RECIPE_NO_TEMP || (step.minTemp >= 0 && step.timeout != 0));
+    }
+};
+
+static_assert(RecipeCheck::valid(recipeFullCip), "FULL CIP recipe violates output interlocks or step rules");
+static_assert(RecipeCheck::valid(recipeQuickRinse), "QUICK RINSE recipe violates output interlocks or step rules");
+static_assert(RecipeCheck::valid(recipeAcidOnly), "ACID ONLY recipe violates output interlocks or step rules");
+static_assert(RecipeCheck::valid(recipeRinseOut), "RINSE OUT recipe violates output interlocks or step rules");
+
+// Названия рецептов в PROGMEM
+const char recipeNameFullCip[] PROGMEM = "FULL CIP";
+const char recipeNameQuickRinse[] PROGMEM = "QUICK RINSE";
+const char recipeNameAcidOnly[] PROGMEM = "ACID ONLY";
+const char recipeNameRinseOut[] PROGMEM = "RINSE OUT";
+const char recipeNameCustom[] PROGMEM = "CUSTOM";
+
+#define RECIPE_STEPS(r) r, sizeof(r) / sizeof(RecipeStep)
+
+// Встроенные рецепты; для RECIPE_CUSTOM шаги берутся из EEPROM
+const RecipeInfo builtinRecipes[RECIPE_COUNT] PROGMEM = {
+    {recipeNameFullCip,    RECIPE_STEPS(recipeFullCip)},
+    {recipeNameQuickRinse, RECIPE_STEPS(recipeQuickRinse)},
+    {recipeNameAcidOnly,   RECIPE_STEPS(recipeAcidOnly)},
+    {recipeNameCustom,     nullptr, 0},
+    {recipeNameRinseOut,   RECIPE_STEPS(recipeRinseOut)}
+};
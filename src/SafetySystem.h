@@ -1,21 +1,19 @@
 #pragma once
-#include <avr/wdt.h> // Для работы с Watchdog Timer
 #include <string.h>  // Для strcmp_P
 #include <Arduino.h> // Для millis()
 
 /*
  * Класс системы безопасности
  * Реализует:
- * - Контроль активности системы (через Watchdog)
  * - Проверку пароля с блокировкой при неверном вводе
+ *
+ * Контроль зависаний ведет TaskWatchdog по пульсу задач планировщика.
  */
 class SafetySystem {
 private:
-    const unsigned long TIMEOUT = 10000UL;      // Таймаут бездействия для Watchdog (мс)
     const uint8_t MAX_ATTEMPTS = 3;             // Макс. число попыток ввода пароля
     const unsigned long LOCK_TIME = 300000UL;   // Время блокировки при неверном вводе (мс)
     
-    unsigned long lastActivity;      // Время последней активности (для Watchdog)
     unsigned long lockUntil;         // Время, до которого система заблокирована
     uint8_t wrongAttempts;           // Количество неверных попыток ввода пароля
 
@@ -29,32 +27,10 @@ public:
      * Конструктор
      */
     SafetySystem() : 
-        lastActivity(millis()), // Инициализация времени последней активности текущим временем
         lockUntil(0),           // Изначально система не заблокирована
         wrongAttempts(0)        // Изначально 0 неверных попыток
     {}
 
-    /*
-     * Проверка таймаута бездействия
-     * Если система не обновляла активность в течение TIMEOUT, вызывается перезагрузка.
-     */
-    void checkActivity() {
-        if((millis() - lastActivity) > TIMEOUT) {
-            // Активируем Watchdog на минимальное время
-            wdt_enable(WDTO_15MS); 
-            // Входим в бесконечный цикл, чтобы Watchdog сработал и перезагрузил устройство
-            while(1); 
-        }
-    }
-
-    /*
-     * Обновление времени последней активности
-     * Сбрасывает таймер Watchdog. Должен вызываться регулярно.
-     */
-    void updateActivity() {
-        lastActivity = millis();
-    }
-
     /*
      * Проверка пароля
      * input - введенный пользователем пароль
@@ -0,0 +1,187 @@
+#pragma once
+#include <Arduino.h>
+#include "AdcSampler.h"
+#include "TemperatureSensor.h"
+#include "SettingsStore.h"
+#include "EventLog.h"
+
+/*
+ * Датчики температуры системы
+ * Номер датчика совпадает с номером канала AdcSampler
+ */
+enum ProbeId : uint8_t {
+    PROBE_TANK_TOP,     // Верх танка (основной датчик охлаждения)
+    PROBE_TANK_BOTTOM,  // Низ танка
+    PROBE_WASH_RETURN,  // Обратная линия мойки
+    PROBE_AMBIENT,      // Окружающий воздух
+    PROBE_COUNT
+};
+
+/*
+ * Источник температуры для регулирования
+ * Значения 0..PROBE_COUNT-1 - отдельный датчик (ProbeId), далее - агрегаты по датчикам танка
+ */
+enum TempSource : uint8_t {
+    SOURCE_TANK_MAX = PROBE_COUNT, // Максимум по исправным датчикам танка
+    SOURCE_TANK_MEAN,              // Среднее по исправным датчикам танка
+    SOURCE_COUNT
+};
+
+/*
+ * Структура калибровки датчиков
+ */
+struct ProbeCalibration {
+    int16_t offsets[PROBE_COUNT] = {0}; // Калибровочные смещения (сотые доли °C)
+} __attribute__((packed));
+
+/*
+ * Класс группы датчиков температуры
+ * Реализует:
+ * - Поочередный фоновый опрос всех датчиков через AdcSampler
+ * - Отфильтрованные значения и признак исправности каждого датчика
+ * - Агрегаты по датчикам танка (максимум, среднее)
+ * - Хранение калибровки каждого датчика в EEPROM
+ * - Запись неисправностей датчиков в журнал событий
+ */
+class SensorArray {
+private:
+    static const uint8_t TANK_PROBES = _BV(PROBE_TANK_TOP) | _BV(PROBE_TANK_BOTTOM);
+
+    const uint8_t* const pins;          // Аналоговые пины датчиков (PROBE_COUNT штук)
+    TemperatureSensor probes[PROBE_COUNT];
+    ProbeCalibration calibration;       // Калибровка (RAM-копия блока SettingsStore)
+    uint8_t loggedFaults = 0;           // Неисправности, уже записанные в журнал событий
+
+    /*
+     * Агрегат по исправным датчикам танка
+     * Возвращает false, если ни один датчик танка не исправен
+     */
+    bool aggregate(uint8_t source, int16_t& result) const {
+        int32_t sum = 0;
+        int16_t maxTemp = INT16_MIN;
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+            if (!(TANK_PROBES & _BV(i)) || !probes[i].isSensorOK()) continue;
+            int16_t temp = probes[i].getTempCenti();
+            sum += temp;
+            if (temp > maxTemp) maxTemp = temp;
+            count++;
+        }
+        if (count == 0) return false;
+        result = (source == SOURCE_TANK_MAX) ? maxTemp : (int16_t)(sum / count);
+        return true;
+    }
+
+public:
+    /*
+     * Конструктор
+     * probePins - массив из PROBE_COUNT аналоговых пинов в порядке ProbeId
+     */
+    SensorArray(const uint8_t* probePins)
+        : pins(probePins),
+          probes{PROBE_TANK_TOP, PROBE_TANK_BOTTOM, PROBE_WASH_RETURN, PROBE_AMBIENT}
+    {}
+
+    /*
+     * Запуск фонового опроса АЦП
+     * Должно вызываться из setup()
+     */
+    void begin() {
+        AdcSampler::begin(pins, PROBE_COUNT);
+    }
+
+    /*
+     * Обновление всех датчиков (неблокирующее, можно вызывать на каждом проходе loop())
+     */
+    void update() {
+        for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+            probes[i].update();
+            // Смена исправности в журнал событий (до первого измерения не учитывается)
+            if (!probes[i].hasReading()) continue;
+            bool fault = !probes[i].isSensorOK();
+            if (fault != ((loggedFaults & _BV(i)) != 0)) {
+                loggedFaults ^= _BV(i);
+                EventLog::append(fault ? LOG_SENSOR_FAULT : LOG_SENSOR_OK, i);
+            }
+        }
+    }
+
+    /*
+     * Доступ к отдельному датчику
+     */
+    TemperatureSensor& probe(ProbeId id) {
+        return probes[id];
+    }
+
+    /*
+     * Проверка исправности источника температуры
+     * Для агрегатов - исправен хотя бы один датчик танка
+     */
+    bool isSensorOK(uint8_t source) const {
+        if (source < PROBE_COUNT) return probes[source].isSensorOK();
+        int16_t unused;
+        return source < SOURCE_COUNT && aggregate(source, unused);
+    }
+
+    /*
+     * Температура источника в сотых долях градуса
+     * Для неисправного источника возвращает 0, проверяйте isSensorOK()
+     */
+    int16_t getTempCenti(uint8_t source) const {
+        if (source < PROBE_COUNT) return probes[source].getTempCenti();
+        int16_t result = 0;
+        if (source < SOURCE_COUNT) aggregate(source, result);
+        return result;
+    }
+
+    /*
+     * Температура источника в градусах Цельсия (°C)
+     */
+    float getTemp(uint8_t source) const {
+        return getTempCenti(source) * 0.01f;
+    }
+
+    /*
+     * Битовая маска неисправных датчиков (бит i - датчик ProbeId i)
+     */
+    uint8_t getFaultMask() const {
+        uint8_t mask = 0;
+        for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+            if (!probes[i].isSensorOK()) mask |= _BV(i);
+        }
+        return mask;
+    }
+
+    /*
+     * Калибровка датчика по эталонной температуре с сохранением в EEPROM
+     */
+    void calibrate(ProbeId id, float referenceTemp) {
+        probes[id].calibrate(referenceTemp);
+        calibration.offsets[id] = probes[id].getCalibration();
+        SettingsStore::save(SETTINGS_CALIBRATION);
+    }
+
+    /*
+     * Сброс калибровки в ноль (из SettingsStore)
+     */
+    void resetCalibration() {
+        calibration = ProbeCalibration();
+    }
+
+    /*
+     * Применение загруженной калибровки к датчикам (из SettingsStore)
+     */
+    bool applyCalibration() {
+        for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+            probes[i].setCalibration(calibration.offsets[i]);
+        }
+        return true;
+    }
+
+    /*
+     * RAM-копия калибровки для SettingsStore
+     */
+    ProbeCalibration& getCalibration() {
+        return calibration;
+    }
+};
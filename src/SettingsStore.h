@@ -0,0 +1,288 @@
+#pragma once
+#include <Arduino.h>
+#include <util/crc16.h> // Для _crc16_update
+#include "EEPROMStorage.h"
+#include "EventLog.h"
+
+/*
+ * Блоки настроек в EEPROM (порядок определяет размещение)
+ */
+enum SettingsBlockId : uint8_t {
+    SETTINGS_COOLER,      // CoolerSettings
+    SETTINGS_MIXER,       // MixerSettings
+    SETTINGS_WASHER,      // WashingSettings
+    SETTINGS_CALIBRATION, // ProbeCalibration
+    SETTINGS_BLOCK_COUNT
+};
+
+/*
+ * Описание блока настроек (таблица заполняется в main.cpp)
+ * Функции вызываются при загрузке:
+ * reset - значения по умолчанию в RAM-копии data
+ * migrate - преобразование данных старой версии (уже скопированных в data поверх
+ *           значений по умолчанию); nullptr - достаточно совпадения начала структуры.
+ *           Версия 0 - данные из разметки до версии 1 (SettingsLayout::LEGACY_SIZE)
+ * apply - проверка и применение загруженных значений; false - значения недопустимы
+ */
+struct SettingsBlock {
+    void* data;       // RAM-копия настроек владельца
+    uint8_t size;     // Размер структуры настроек
+    uint8_t version;  // Текущая версия структуры (увеличивается при изменении полей)
+    void (*reset)();
+    bool (*migrate)(uint8_t fromVersion);
+    bool (*apply)();
+};
+
+/*
+ * Размещение блоков в EEPROM (вычисляется на этапе компиляции)
+ * Под каждый блок зарезервирована своя емкость: рост одной структуры
+ * в пределах емкости не сдвигает остальные блоки.
+ */
+struct SettingsLayout {
+    static const uint8_t VERSION = 1;  // Версия разметки (заголовок, емкости блоков)
+    static const int HEADER_SIZE = 6;  // sizeof(SettingsStore::Header)
+    static const int BLOCK_HEADER_SIZE = 4; // sizeof(SettingsStore::BlockHeader)
+
+    // Емкость данных каждого блока (байт), в порядке SettingsBlockId
+    static constexpr uint8_t CAPACITY[SETTINGS_BLOCK_COUNT] = {16, 8, 64, 12};
+
+    // Размер данных блоков в разметке до версии 1 (без заголовков, блоки подряд,
+    // за каждым - байт инвертированной суммы); 0 - блока в ней не было.
+    // Компрессор: targetTemp, hysteresis, minInterval; миксер: mode, workTime,
+    // idleTime; мойка: uint16_t stageTimes[5]
+    static constexpr uint8_t LEGACY_SIZE[SETTINGS_BLOCK_COUNT] = {10, 5, 10, 0};
+
+    static constexpr int address(uint8_t id) {
+        int result = HEADER_SIZE;
+        for (uint8_t i = 0; i < id; i++) result += BLOCK_HEADER_SIZE + CAPACITY[i];
+        return result;
+    }
+
+    static constexpr int legacyAddress(uint8_t id) {
+        int result = 0;
+        for (uint8_t i = 0; i < id; i++) {
+            if (LEGACY_SIZE[i] != 0) result += LEGACY_SIZE[i] + 1;
+        }
+        return result;
+    }
+
+    // Конец области настроек
+    static constexpr int end() {
+        return address(SETTINGS_BLOCK_COUNT);
+    }
+};
+
+// Адреса из прошивки до версии 1: компрессор с 0, миксер с 11, мойка с 17
+static_assert(SettingsLayout::legacyAddress(SETTINGS_MIXER) == 11 &&
+              SettingsLayout::legacyAddress(SETTINGS_WASHER) == 17,
+              "SettingsLayout: legacy addresses must match the pre-version-1 firmware");
+
+/*
+ * Хранилище настроек
+ * Реализует:
+ * - Единый реестр блоков настроек с заголовком разметки в начале EEPROM
+ * - Версию и CRC-16 на каждый блок: поврежденный блок сбрасывается
+ *   к значениям по умолчанию, не затрагивая остальные
+ * - Миграцию: блок старой версии читается поверх значений по умолчанию
+ *   (новые поля добавляются в конец структуры) и передается в migrate()
+ * - Перенос настроек из разметки до версии 1 (блоки подряд с 8-битной суммой)
+ * - Загрузку всех блоков за один проход при запуске
+ *
+ * Формат: заголовок {magic, версия разметки, число блоков, CRC-16},
+ * затем блоки {версия, размер, CRC-16, данные} по адресам SettingsLayout.
+ */
+class SettingsStore {
+public:
+    /*
+     * Загрузка всех блоков (из setup(), до запуска задач)
+     * table - SETTINGS_BLOCK_COUNT описаний в порядке SettingsBlockId
+     * Возвращает true, если все блоки загружены без сброса к значениям по умолчанию
+     */
+    static bool load(const SettingsBlock* table) {
+        blocks = table;
+        Header header;
+        EEPROMStorage::read(0, header);
+
+        loading = true;
+        defaultsMask = 0;
+        bool hasHeader = (header.magic == MAGIC && header.crc == headerCrc(header));
+        if (hasHeader && header.layout == SettingsLayout::VERSION &&
+            header.blockCount <= SETTINGS_BLOCK_COUNT) {
+            for (uint8_t id = 0; id < SETTINGS_BLOCK_COUNT; id++) {
+                // Блок, добавленный в новой прошивке, получает значения по умолчанию
+                if (id >= header.blockCount || !loadBlock(id)) {
+                    useDefaults(id);
+                    save(id); // Чтобы ошибка не повторялась при каждом запуске
+                }
+            }
+            if (header.blockCount != SETTINGS_BLOCK_COUNT) saveAll();
+        } else if (!hasHeader) {
+            // Нет заголовка: EEPROM чистая или записана прошивкой до версии 1
+            for (uint8_t id = 0; id < SETTINGS_BLOCK_COUNT; id++) {
+                if (!loadLegacyBlock(id)) useDefaults(id);
+            }
+            saveAll();
+        } else {
+            // Разметка другой версии (откат прошивки): перенос не предусмотрен
+            for (uint8_t id = 0; id < SETTINGS_BLOCK_COUNT; id++) useDefaults(id);
+            saveAll();
+        }
+        loading = false;
+        // Одна запись в журнал событий вместо записи на каждый блок
+        if (defaultsMask != 0) EventLog::append(LOG_SETTINGS_RESET, defaultsMask);
+        return defaultsMask == 0;
+    }
+
+    /*
+     * Сохранение блока из RAM-копии (пишутся только изменившиеся байты)
+     * В журнал попадает только сохранение, изменившее EEPROM
+     */
+    static void save(uint8_t id) {
+        if (blocks == nullptr || id >= SETTINGS_BLOCK_COUNT) return;
+        const SettingsBlock& block = blocks[id];
+        BlockHeader header;
+        header.version = block.version;
+        header.size = block.size;
+        header.crc = blockCrc(id, header.version, header.size,
+                              static_cast<const uint8_t*>(block.data));
+        int address = SettingsLayout::address(id);
+        bool changed = EEPROMStorage::write(address, header);
+        if (EEPROMStorage::writeBytes(address + sizeof(BlockHeader), block.data, block.size)) {
+            changed = true;
+        }
+        if (changed && !loading) EventLog::append(LOG_SETTINGS_SAVED, id);
+    }
+
+private:
+    static const uint16_t MAGIC = 0x5743; // "WC"
+
+    struct Header {
+        uint16_t magic;     // MAGIC
+        uint8_t layout;     // SettingsLayout::VERSION
+        uint8_t blockCount; // Количество блоков
+        uint16_t crc;       // CRC-16 предыдущих полей
+    } __attribute__((packed));
+
+    struct BlockHeader {
+        uint8_t version; // Версия структуры
+        uint8_t size;    // Размер данных
+        uint16_t crc;    // CRC-16 номера блока, версии, размера и данных
+    } __attribute__((packed));
+
+    static_assert(sizeof(Header) == SettingsLayout::HEADER_SIZE, "SettingsStore: header size");
+    static_assert(sizeof(BlockHeader) == SettingsLayout::BLOCK_HEADER_SIZE,
+                  "SettingsStore: block header size");
+
+    static const SettingsBlock* blocks; // Таблица блоков
+    static bool loading;                // Идет загрузка (сохранения не журналируются)
+    static uint8_t defaultsMask;        // Блоки, сброшенные при загрузке
+
+    static uint16_t headerCrc(const Header& header) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&header);
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 0; i < sizeof(Header) - sizeof(header.crc); i++) {
+            crc = _crc16_update(crc, p[i]);
+        }
+        return crc;
+    }
+
+    /*
+     * CRC-16 блока; data == nullptr - данные читаются из EEPROM
+     */
+    static uint16_t blockCrc(uint8_t id, uint8_t version, uint8_t size, const uint8_t* data) {
+        uint16_t crc = 0xFFFF;
+        crc = _crc16_update(crc, id);
+        crc = _crc16_update(crc, version);
+        crc = _crc16_update(crc, size);
+        int address = SettingsLayout::address(id) + sizeof(BlockHeader);
+        for (uint8_t i = 0; i < size; i++) {
+            crc = _crc16_update(crc, data ? data[i] : EEPROMStorage::readByte(address + i));
+        }
+        return crc;
+    }
+
+    /*
+     * Загрузка блока текущей разметки
+     * Блок новее прошивки (откат версии) не читается - его поля неизвестны
+     */
+    static bool loadBlock(uint8_t id) {
+        const SettingsBlock& block = blocks[id];
+        BlockHeader header;
+        int address = SettingsLayout::address(id);
+        EEPROMStorage::read(address, header);
+        if (header.size > SettingsLayout::CAPACITY[id] || header.version > block.version ||
+            header.crc != blockCrc(id, header.version, header.size, nullptr)) {
+            return false;
+        }
+
+        block.reset();
+        // Поля, которых нет в старой версии, остаются по умолчанию
+        uint8_t size = (header.size < block.size) ? header.size : block.size;
+        EEPROMStorage::readBytes(address + sizeof(BlockHeader), block.data, size);
+        if (header.version < block.version) {
+            if (block.migrate != nullptr && !block.migrate(header.version)) return false;
+            if (!block.apply()) return false;
+            save(id); // Сохраняем в новой версии
+            return true;
+        }
+        return block.apply();
+    }
+
+    /*
+     * Загрузка блока из разметки до версии 1
+     * Проверка - инвертированная 8-битная сумма; данные копируются поверх
+     * значений по умолчанию и передаются в migrate(0).
+     * Блок, которого в старой разметке не было, получает значения по умолчанию
+     * без признака сброса.
+     */
+    static bool loadLegacyBlock(uint8_t id) {
+        const SettingsBlock& block = blocks[id];
+        uint8_t size = SettingsLayout::LEGACY_SIZE[id];
+        if (size == 0) {
+            block.reset();
+            return block.apply();
+        }
+        if (size > block.size) return false;
+        int address = SettingsLayout::legacyAddress(id);
+
+        uint8_t sum = 0;
+        for (uint8_t i = 0; i < size; i++) sum += EEPROMStorage::readByte(address + i);
+        if ((uint8_t)~sum != EEPROMStorage::readByte(address + size)) return false;
+
+        block.reset();
+        EEPROMStorage::readBytes(address, block.data, size);
+        if (block.migrate != nullptr && !block.migrate(0)) return false;
+        return block.apply();
+    }
+
+    static void useDefaults(uint8_t id) {
+        defaultsMask |= _BV(id);
+        blocks[id].reset();
+        blocks[id].apply();
+    }
+
+    /*
+     * Запись всех блоков и заголовка (после переноса или добавления блоков)
+     * Заголовок пишется после того, как блоки физически записаны (барьер
+     * EEPROMStorage::flushCache(), до 0.4 с при запуске): при сбое питания
+     * до него следующий запуск снова пойдет по прежней ветке, и блоки
+     * с неверной CRC получат значения по умолчанию
+     */
+    static void saveAll() {
+        for (uint8_t id = 0; id < SETTINGS_BLOCK_COUNT; id++) save(id);
+        EEPROMStorage::flushCache();
+        Header header;
+        header.magic = MAGIC;
+        header.layout = SettingsLayout::VERSION;
+        header.blockCount = SETTINGS_BLOCK_COUNT;
+        header.crc = headerCrc(header);
+        EEPROMStorage::write(0, header);
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    SettingsStore() = delete;
+};
+
+const SettingsBlock* SettingsStore::blocks = nullptr;
+bool SettingsStore::loading = false;
+uint8_t SettingsStore::defaultsMask = 0;
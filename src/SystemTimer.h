@@ -0,0 +1,147 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/interrupt.h> // Для ISR()
+#include <util/atomic.h>   // Для ATOMIC_BLOCK
+
+/*
+ * Системный таймер на Timer1
+ * Реализует:
+ * - Миллисекундный счетчик на прерывании по совпадению (CTC, 1 кГц)
+ * - Точное время с шагом 0.5 мкс (миллисекунды + TCNT1)
+ * - Один аппаратный дедлайн: обработчик вызывается из прерывания
+ *   в ту миллисекунду, на которую он назначен, независимо от главного цикла
+ * - Замер запаздывания срабатывания дедлайна (джиттера)
+ *
+ * Timer1 занят этим классом: analogWrite() на пинах 9 и 10 недоступен.
+ */
+class SystemTimer {
+public:
+    static const uint16_t TICKS_PER_MS = 2000; // Тиков TCNT1 в миллисекунде (предделитель 8)
+
+    typedef void (*DeadlineHandler)(void* context);
+
+    /*
+     * Запуск таймера
+     * Вызывать из setup(): init() ядра Arduino настраивает Timer1 под ШИМ
+     */
+    static void begin() {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            TCCR1A = 0;
+            TCCR1B = _BV(WGM12) | _BV(CS11); // CTC по OCR1A, предделитель 8
+            OCR1A = TICKS_PER_MS - 1;
+            TCNT1 = 0;
+            TIFR1 = _BV(OCF1A);
+            TIMSK1 = _BV(OCIE1A);
+            milliseconds = 0;
+        }
+    }
+
+    /*
+     * Количество миллисекунд с момента begin()
+     */
+    static uint32_t getMillis() {
+        uint32_t result;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            result = milliseconds;
+        }
+        return result;
+    }
+
+    /*
+     * Точное время в тиках по 0.5 мкс (переполняется примерно через 36 минут)
+     * Подходит для измерения коротких интервалов
+     */
+    static uint32_t ticks() {
+        uint32_t ms;
+        uint16_t count;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            ms = milliseconds;
+            count = TCNT1;
+            // Совпадение уже произошло, но прерывание еще не обработано
+            if ((TIFR1 & _BV(OCF1A)) && count < TICKS_PER_MS / 2) {
+                ms++;
+            }
+        }
+        return ms * TICKS_PER_MS + count;
+    }
+
+    /*
+     * Назначение дедлайна
+     * deadlineMs - момент срабатывания по шкале SystemTimer::getMillis()
+     * handler - обработчик, вызывается из прерывания (должен быть коротким)
+     * Новый дедлайн заменяет предыдущий.
+     */
+    static void arm(uint32_t deadlineMs, DeadlineHandler handler, void* context) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            deadline = deadlineMs;
+            deadlineHandler = handler;
+            deadlineContext = context;
+        }
+    }
+
+    /*
+     * Отмена дедлайна
+     */
+    static void disarm() {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            deadlineHandler = nullptr;
+        }
+    }
+
+    /*
+     * Запаздывание последнего и максимальное запаздывание срабатывания (мкс)
+     * Считается от момента дедлайна до входа в обработчик
+     */
+    static uint16_t getLastJitterUs() { return atomicRead(lastJitter) / 2; }
+    static uint16_t getMaxJitterUs() { return atomicRead(maxJitter) / 2; }
+
+    /*
+     * Обработка прерывания по совпадению
+     * Вызывается только из ISR(TIMER1_COMPA_vect)
+     */
+    static void onTick() {
+        milliseconds++;
+        if (deadlineHandler == nullptr) return;
+        if ((int32_t)(milliseconds - deadline) < 0) return;
+
+        // Запаздывание: целые миллисекунды плюс время входа в прерывание
+        uint32_t late = (milliseconds - deadline) * TICKS_PER_MS + TCNT1;
+        lastJitter = (late > 0xFFFF) ? 0xFFFF : (uint16_t)late;
+        if (lastJitter > maxJitter) maxJitter = lastJitter;
+
+        DeadlineHandler handler = deadlineHandler;
+        deadlineHandler = nullptr; // Дедлайн однократный; обработчик может назначить новый
+        handler(deadlineContext);
+    }
+
+private:
+    static volatile uint32_t milliseconds;       // Счетчик миллисекунд
+    static volatile uint32_t deadline;           // Момент срабатывания дедлайна
+    static DeadlineHandler volatile deadlineHandler; // Обработчик (nullptr - дедлайна нет)
+    static void* volatile deadlineContext;       // Контекст обработчика
+    static volatile uint16_t lastJitter;         // Последнее запаздывание (тики 0.5 мкс)
+    static volatile uint16_t maxJitter;          // Максимальное запаздывание (тики 0.5 мкс)
+
+    static uint16_t atomicRead(volatile uint16_t& value) {
+        uint16_t result;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            result = value;
+        }
+        return result;
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    SystemTimer() = delete;
+};
+
+volatile uint32_t SystemTimer::milliseconds = 0;
+volatile uint32_t SystemTimer::deadline = 0;
+SystemTimer::DeadlineHandler volatile SystemTimer::deadlineHandler = nullptr;
+void* volatile SystemTimer::deadlineContext = nullptr;
+volatile uint16_t SystemTimer::lastJitter = 0;
+volatile uint16_t SystemTimer::maxJitter = 0;
+
+// Прерывание Timer1 по совпадению с OCR1A (1 кГц)
+ISR(TIMER1_COMPA_vect) {
+    SystemTimer::onTick();
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <Arduino.h>
+#include "SystemTimer.h"
+
+/*
+ * Профилирование задач планировщика
+ * Реализует:
+ * - Время выполнения каждой задачи: минимум, среднее, максимум
+ * - Гистограмму запаздывания запуска относительно планового момента (джиттер)
+ * - Долю времени простоя процессора
+ * - Компактный отчет в Serial по запросу (печатает TaskScheduler::printReport())
+ *
+ * Время измеряется по Timer1 (SystemTimer::ticks(), шаг 0.5 мкс = 8 тактов),
+ * сам замер занимает несколько микросекунд на запуск задачи.
+ * Отключается сборкой с -D TASK_PROFILER=0 (экономия 22 байт RAM на задачу).
+ */
+#ifndef TASK_PROFILER
+#define TASK_PROFILER 1
+#endif
+
+class TaskProfiler {
+public:
+    static const uint8_t MAX_TASKS = 9;   // Максимум профилируемых задач
+    static const uint8_t BUCKETS = 6;     // Корзин гистограммы джиттера
+
+    /*
+     * Учет одного запуска задачи
+     * index - номер задачи в таблице планировщика
+     * lateTicks - запаздывание запуска, execTicks - время выполнения (тики 0.5 мкс)
+     */
+    static void record(uint8_t index, uint32_t lateTicks, uint32_t execTicks) {
+        if (index >= MAX_TASKS) return;
+        Stats& s = stats[index];
+        uint16_t exec = (execTicks > 0xFFFF) ? 0xFFFF : (uint16_t)execTicks;
+        if (s.count == 0 || exec < s.minTicks) s.minTicks = exec;
+        if (exec > s.maxTicks) s.maxTicks = exec;
+        if (s.count == 0xFFFF) {
+            // Счетчик насыщен: уменьшаем вдвое, сохраняя среднее
+            s.count >>= 1;
+            s.sumTicks >>= 1;
+        }
+        s.count++;
+        s.sumTicks += exec;
+
+        uint8_t bucket = 0;
+        while (bucket < BUCKETS - 1 && lateTicks >= pgm_read_dword(&bucketLimits[bucket])) {
+            bucket++;
+        }
+        if (s.histogram[bucket] < 0xFFFF) s.histogram[bucket]++;
+    }
+
+    /*
+     * Учет времени простоя (тики 0.5 мкс)
+     * Накапливается в миллисекундах: 32-битный счет тиков переполнился бы
+     * через 35.8 минуты, а окно измерений может длиться сутками
+     */
+    static void recordIdle(uint32_t idleTicks) {
+        idleTicks += idleRemainder;
+        idleMs += idleTicks / SystemTimer::TICKS_PER_MS;
+        idleRemainder = idleTicks % SystemTimer::TICKS_PER_MS;
+    }
+
+    /*
+     * Заголовок отчета
+     */
+    static void printHeader(Print& out) {
+        out.println(F("task     runs min/avg/max us ovr late ms | jitter <0.1 <0.5 <1 <5 <20 >20 ms"));
+    }
+
+    /*
+     * Строка отчета по задаче
+     * name - название (PROGMEM), overruns и maxLate - счетчики планировщика
+     */
+    static void printTask(Print& out, uint8_t index, const char* name,
+                          uint16_t overruns, uint16_t maxLate) {
+        if (index >= MAX_TASKS) return;
+        const Stats& s = stats[index];
+        printPadded(out, name, 8);
+        out.print(' ');
+        out.print(s.count);
+        out.print(' ');
+        out.print(s.minTicks / 2);
+        out.print('/');
+        out.print(s.count ? (unsigned int)(s.sumTicks / s.count / 2) : 0U);
+        out.print('/');
+        out.print(s.maxTicks / 2);
+        out.print(' ');
+        out.print(overruns);
+        out.print(' ');
+        out.print(maxLate);
+        out.print(F(" |"));
+        for (uint8_t b = 0; b < BUCKETS; b++) {
+            out.print(' ');
+            out.print(s.histogram[b]);
+        }
+        out.println();
+    }
+
+    /*
+     * Доля простоя процессора с начала окна измерений (окно - до 49 суток)
+     */
+    static void printIdle(Print& out) {
+        uint32_t window = (SystemTimer::getMillis() - windowStart) / 100; // Сотая часть окна
+        out.print(F("idle %: "));
+        out.println(window ? (unsigned int)(idleMs / window) : 0U);
+    }
+
+    /*
+     * Сброс статистики и начало нового окна измерений
+     */
+    static void reset() {
+        memset(stats, 0, sizeof(stats));
+        idleMs = 0;
+        idleRemainder = 0;
+        windowStart = SystemTimer::getMillis();
+    }
+
+private:
+    struct Stats {
+        uint16_t count;              // Количество запусков
+        uint16_t minTicks;           // Минимальное время выполнения
+        uint16_t maxTicks;           // Максимальное время выполнения
+        uint32_t sumTicks;           // Сумма времени выполнения
+        uint16_t histogram[BUCKETS]; // Запуски по корзинам запаздывания
+    };
+
+    // Верхние границы корзин запаздывания (тики 0.5 мкс): 0.1, 0.5, 1, 5, 20 мс
+    static const uint32_t bucketLimits[BUCKETS - 1] PROGMEM;
+
+    static Stats stats[MAX_TASKS];
+    static uint32_t idleMs;        // Время простоя в текущем окне (мс)
+    static uint16_t idleRemainder; // Остаток простоя меньше миллисекунды (тики)
+    static uint32_t windowStart;   // Начало окна измерений (мс)
+
+    /*
+     * Печать названия из PROGMEM с выравниванием пробелами
+     */
+    static void printPadded(Print& out, const char* name, uint8_t width) {
+        uint8_t length = 0;
+        char c;
+        while ((c = pgm_read_byte(name++))) {
+            out.print(c);
+            length++;
+        }
+        while (length++ < width) out.print(' ');
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    TaskProfiler() = delete;
+};
+
+const uint32_t TaskProfiler::bucketLimits[BUCKETS - 1] PROGMEM = {
+    200, 1000, 2000, 10000, 40000
+};
+TaskProfiler::Stats TaskProfiler::stats[MAX_TASKS];
+uint32_t TaskProfiler::idleMs = 0;
+uint16_t TaskProfiler::idleRemainder = 0;
+uint32_t TaskProfiler::windowStart = 0;
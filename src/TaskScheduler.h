@@ -0,0 +1,164 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/sleep.h>     // Для sleep_mode()
+#include "SystemTimer.h"
+#include "TaskProfiler.h"
+
+/*
+ * Периодическая задача планировщика
+ * Заполняется статически в main.cpp; поля после priority ведет планировщик
+ */
+struct Task {
+    const char* name;     // Название задачи (PROGMEM), для отчетов
+    void (*run)();        // Функция задачи (должна возвращаться быстро)
+    uint16_t period;      // Период запуска (мс)
+    uint8_t priority;     // Приоритет: 0 - высший
+    uint16_t deadline;    // Допустимое время без завершения запуска (мс), 0 - без контроля
+    uint32_t nextRun;     // Следующий плановый запуск (SystemTimer::getMillis())
+    uint16_t overruns;    // Количество пропущенных периодов
+    uint16_t maxLate;     // Максимальное запаздывание запуска (мс)
+    uint16_t lastDone;    // Младшие 16 бит момента завершения последнего запуска (мс)
+};
+
+/*
+ * Кооперативный планировщик периодических задач
+ * Реализует:
+ * - Запуск задач по собственному периоду, из готовых - с высшим приоритетом
+ * - Расписание без накопления ошибки: следующий запуск = плановый + период
+ * - Обнаружение переполнения: если задача запоздала на целый период,
+ *   пропущенные запуски не догоняются, а засчитываются в overruns
+ * - Простой до ближайшего дедлайна в режиме IDLE вместо холостого цикла
+ *   (прерывания АЦП, таймеров, TWI и UART продолжают работать)
+ * - Отметку времени завершения каждого запуска (пульс для TaskWatchdog)
+ *
+ * После каждой задачи выбор начинается заново, поэтому задача
+ * с высоким приоритетом ждет не дольше одной самой длинной задачи.
+ */
+class TaskScheduler {
+public:
+    /*
+     * Регистрация таблицы задач (вызывать из setup())
+     * Первые запуски всех задач - сразу
+     */
+    static void begin(Task* taskTable, uint8_t count) {
+        tasks = taskTable;
+        taskCount = count;
+        uint32_t now = SystemTimer::getMillis();
+#if TASK_PROFILER
+        TaskProfiler::reset();
+#endif
+        for (uint8_t i = 0; i < taskCount; i++) {
+            tasks[i].nextRun = now;
+            tasks[i].overruns = 0;
+            tasks[i].maxLate = 0;
+            tasks[i].lastDone = (uint16_t)now;
+        }
+    }
+
+    /*
+     * Один проход планировщика (вызывать из loop())
+     * Выполняет одну готовую задачу; если готовых нет - простой до ближайшего дедлайна
+     */
+    static void run() {
+        uint32_t now = SystemTimer::getMillis();
+        Task* ready = nullptr;
+        uint32_t nearest = now + 0xFFFF;
+        for (uint8_t i = 0; i < taskCount; i++) {
+            Task& task = tasks[i];
+            if ((int32_t)(now - task.nextRun) >= 0) {
+                if (ready == nullptr || task.priority < ready->priority) ready = &task;
+            } else if ((int32_t)(task.nextRun - nearest) < 0) {
+                nearest = task.nextRun;
+            }
+        }
+
+        if (ready != nullptr) {
+            dispatch(*ready, (uint8_t)(ready - tasks), now);
+        } else {
+            idleUntil(nearest);
+        }
+    }
+
+    /*
+     * Доступ к таблице задач (для отчетов)
+     */
+    static uint8_t getTaskCount() { return taskCount; }
+    static const Task& getTask(uint8_t index) { return tasks[index]; }
+
+    /*
+     * Номер выполняемой задачи (NO_TASK - планировщик или простой)
+     */
+    static uint8_t getCurrent() { return current; }
+
+    static const uint8_t NO_TASK = 0xFF;
+
+#if TASK_PROFILER
+    /*
+     * Отчет профилировщика по всем задачам; статистика после печати сбрасывается
+     */
+    static void printReport(Print& out) {
+        TaskProfiler::printHeader(out);
+        for (uint8_t i = 0; i < taskCount; i++) {
+            TaskProfiler::printTask(out, i, tasks[i].name, tasks[i].overruns, tasks[i].maxLate);
+        }
+        TaskProfiler::printIdle(out);
+        TaskProfiler::reset();
+    }
+#endif
+
+private:
+    static Task* tasks;        // Таблица задач
+    static uint8_t taskCount;  // Количество задач
+    static volatile uint8_t current; // Выполняемая задача (читает прерывание сторожевого таймера)
+
+    /*
+     * Запуск задачи и расчет следующего планового запуска
+     */
+    static void dispatch(Task& task, uint8_t index, uint32_t now) {
+        uint32_t late = now - task.nextRun;
+        if (late > task.maxLate) task.maxLate = (late > 0xFFFF) ? 0xFFFF : (uint16_t)late;
+
+        current = index;
+#if TASK_PROFILER
+        uint32_t start = SystemTimer::ticks();
+        task.run();
+        TaskProfiler::record(index, start - task.nextRun * SystemTimer::TICKS_PER_MS,
+                             SystemTimer::ticks() - start);
+#else
+        task.run();
+#endif
+        current = NO_TASK;
+        task.lastDone = (uint16_t)SystemTimer::getMillis();
+
+        task.nextRun += task.period;
+        if ((int32_t)(now - task.nextRun) >= 0) {
+            // Пропущен целый период: фиксируем переполнение и не догоняем
+            if (task.overruns < 0xFFFF) task.overruns++;
+            task.nextRun = now + task.period;
+        }
+    }
+
+    /*
+     * Простой до момента deadline
+     * Процессор будят прерывания SystemTimer (каждую миллисекунду) и остальные
+     */
+    static void idleUntil(uint32_t deadline) {
+#if TASK_PROFILER
+        uint32_t start = SystemTimer::ticks();
+#endif
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        while ((int32_t)(SystemTimer::getMillis() - deadline) < 0) {
+            sleep_mode();
+        }
+#if TASK_PROFILER
+        TaskProfiler::recordIdle(SystemTimer::ticks() - start);
+#endif
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    TaskScheduler() = delete;
+};
+
+Task* TaskScheduler::tasks = nullptr;
+uint8_t TaskScheduler::taskCount = 0;
+volatile uint8_t TaskScheduler::current = TaskScheduler::NO_TASK;
@@ -0,0 +1,163 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/interrupt.h> // Для ISR()
+#include <avr/wdt.h>       // Для wdt_reset(), wdt_disable()
+#include <util/atomic.h>   // Для ATOMIC_BLOCK
+#include "TaskScheduler.h"
+#include "SystemTimer.h"
+
+/*
+ * Сторожевой таймер с контролем задач
+ * Реализует:
+ * - Аппаратный WDT сбрасывается, только пока каждая задача с ненулевым
+ *   deadline в таблице планировщика завершает запуски не реже своего срока
+ * - Режим "прерывание, затем сброс": первое срабатывание WDT записывает
+ *   виновника в неинициализируемую RAM, второе перезагружает контроллер.
+ *   Между ними прерывание EE_READY успевает дописать кэш EEPROM.
+ * - Виновник: задача, на которой завис главный цикл (при зависании
+ *   просрочены все задачи, поэтому выполняемая задача важнее), иначе
+ *   задача, сильнее всех просрочившая срок; NO_TASK - причина вне задач
+ * - Причину сброса из MCUSR, сохраненную кодом запуска (.init3)
+ *   до того, как WDT после сброса снова сработает
+ *
+ * Optiboot сбрасывает MCUSR сам и передает его значение в r2: если MCUSR
+ * пуст, флаги берутся оттуда. Загрузчик, не передающий флаги, дает
+ * неизвестную причину.
+ */
+class TaskWatchdog {
+public:
+    static const uint8_t TIMEOUT = WDTO_2S; // Период WDT (до прерывания и еще раз до сброса)
+
+    /*
+     * Запуск WDT (из setup(), после TaskScheduler::begin() и всех delay())
+     */
+    static void begin() {
+        tripped = false;
+        uint8_t prescaler = (TIMEOUT & 0x07) | ((TIMEOUT & 0x08) ? _BV(WDP3) : 0);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            wdt_reset();
+            WDTCSR = _BV(WDCE) | _BV(WDE);             // Разрешение изменения (4 такта)
+            WDTCSR = _BV(WDIE) | _BV(WDE) | prescaler; // Прерывание, затем сброс
+        }
+    }
+
+    /*
+     * Сброс WDT, если все контролируемые задачи живы (из loop(), на каждом проходе)
+     */
+    static void service() {
+        if (tripped || findOverdue() != TaskScheduler::NO_TASK) return;
+        wdt_reset();
+    }
+
+    /*
+     * Флаги MCUSR последнего сброса (PORF, EXTRF, BORF, WDRF)
+     */
+    static uint8_t getResetFlags() {
+        return resetFlags;
+    }
+
+    /*
+     * Задача, вызвавшая последний сброс по WDT; NO_TASK - неизвестна
+     */
+    static uint8_t getCulprit() {
+        return record.culprit;
+    }
+
+    /*
+     * Отчет о последнем сбросе в Serial: "reset: флаги task: задача"
+     */
+    static void printReport(Print& out) {
+        out.print(F("reset:"));
+        if (resetFlags & _BV(PORF)) out.print(F(" power"));
+        if (resetFlags & _BV(EXTRF)) out.print(F(" external"));
+        if (resetFlags & _BV(BORF)) out.print(F(" brownout"));
+        if (resetFlags & _BV(WDRF)) out.print(F(" watchdog"));
+        if ((resetFlags & 0x0F) == 0) out.print(F(" unknown"));
+        out.print(F(" task: "));
+        uint8_t culprit = getCulprit();
+        if (culprit < TaskScheduler::getTaskCount()) {
+            out.println((const __FlashStringHelper*)TaskScheduler::getTask(culprit).name);
+        } else {
+            out.println('-');
+        }
+    }
+
+    /*
+     * Сохранение причины сброса и выключение WDT
+     * Вызывается только кодом запуска из .init3: после сброса по WDT
+     * он остается включенным с периодом 15 мс
+     */
+    __attribute__((always_inline)) static inline void captureResetFlags() {
+        uint8_t flags = MCUSR;
+        if (flags == 0) __asm__ __volatile__("mov %0, r2" : "=r"(flags)); // Флаги от Optiboot
+        resetFlags = flags & 0x0F;
+        MCUSR = 0;
+        wdt_disable();
+        // Запись действительна один запуск: иначе сброс без прерывания WDT
+        // повторил бы прошлого виновника
+        bool valid = (flags & _BV(WDRF)) && record.check == (uint8_t)~record.culprit;
+        if (!valid) record.culprit = TaskScheduler::NO_TASK;
+        record.check = record.culprit;
+    }
+
+    /*
+     * Первое срабатывание WDT (только из ISR(WDT_vect))
+     * Следующее срабатывание перезагрузит контроллер: WDIE сброшен аппаратно
+     */
+    static void onTimeout() {
+        uint8_t culprit = TaskScheduler::getCurrent();
+        if (culprit == TaskScheduler::NO_TASK) culprit = findOverdue();
+        record.culprit = culprit;
+        record.check = ~culprit;
+        tripped = true;
+    }
+
+private:
+    // Виновник сброса, переживает перезагрузку (.noinit не обнуляется при запуске)
+    struct Record {
+        uint8_t culprit; // Номер задачи в таблице планировщика
+        uint8_t check;   // ~culprit: содержимое RAM после включения питания не примется
+    };
+
+    static Record record;
+    static uint8_t resetFlags;       // Флаги MCUSR, сохраненные при запуске
+    static volatile bool tripped;    // WDT сработал: сброс неизбежен, WDT больше не сбрасывается
+
+    /*
+     * Задача, дольше всех превысившая свой срок; NO_TASK - все живы
+     */
+    static uint8_t findOverdue() {
+        uint16_t now = (uint16_t)SystemTimer::getMillis();
+        uint8_t result = TaskScheduler::NO_TASK;
+        uint16_t worst = 0;
+        for (uint8_t i = 0; i < TaskScheduler::getTaskCount(); i++) {
+            const Task& task = TaskScheduler::getTask(i);
+            if (task.deadline == 0) continue;
+            uint16_t age = now - task.lastDone;
+            if (age > task.deadline && (uint16_t)(age - task.deadline) >= worst) {
+                worst = age - task.deadline;
+                result = i;
+            }
+        }
+        return result;
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    TaskWatchdog() = delete;
+};
+
+TaskWatchdog::Record TaskWatchdog::record __attribute__((section(".noinit")));
+uint8_t TaskWatchdog::resetFlags __attribute__((section(".noinit")));
+volatile bool TaskWatchdog::tripped = false;
+
+// Причина сброса до инициализации .data/.bss: функция встраивается
+// в код запуска, поэтому naked и без возврата
+void taskWatchdogCapture() __attribute__((naked, used, section(".init3")));
+void taskWatchdogCapture() {
+    TaskWatchdog::captureResetFlags();
+}
+
+// WDT не сброшен за TIMEOUT: запись виновника перед сбросом
+ISR(WDT_vect) {
+    TaskWatchdog::onTimeout();
+}
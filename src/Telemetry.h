@@ -0,0 +1,179 @@
+#pragma once
+#include <Arduino.h>
+#include <util/crc16.h> // Для _crc16_update
+#include "SystemTimer.h"
+#include "TaskScheduler.h"
+
+/*
+ * Пакет состояния телеметрии (27 байт, little-endian, без выравнивания)
+ * Поля после uptime заполняет main.cpp; при изменении полей увеличивается
+ * TELEMETRY_STATE и обновляется tools/telemetry_decode.py
+ */
+struct TelemetryPacket {
+    uint8_t type;       // Тип и версия раскладки пакета (TELEMETRY_STATE)
+    uint8_t seq;        // Номер пакета (пропуски видны на приемнике)
+    uint32_t uptime;    // Время от запуска (мс)
+    int16_t temps[4];   // Температуры датчиков в порядке ProbeId (сотые доли °C)
+    uint8_t faults;     // Неисправные датчики (бит на ProbeId)
+    uint8_t outputs;    // Включенные выходы (биты Output)
+    uint8_t held;       // Выходы, удержанные блокировкой
+    uint8_t flags;      // TELEMETRY_FLAG_*
+    uint8_t stage;      // Шаг мойки (0 - мойка не идет)
+    uint16_t timeLeft;  // Осталось до конца шага (сек)
+    uint16_t maxLate;   // Максимальное запаздывание запуска задач (мс)
+    uint16_t jitter;    // Максимальное запаздывание прерывания SystemTimer (мкс)
+    uint16_t overruns;  // Пропущенные периоды задач (сумма)
+} __attribute__((packed));
+
+#define TELEMETRY_STATE 0x01 // Пакет состояния, раскладка 1
+
+// Биты поля flags
+#define TELEMETRY_FLAG_WASHING   0x01 // Идет мойка
+#define TELEMETRY_FLAG_WAITING   0x02 // Шаг ждет температуру
+#define TELEMETRY_FLAG_TEMP_FAULT 0x04 // Последняя мойка не достигла температуры
+#define TELEMETRY_FLAG_COOLING   0x08 // Компрессор включен (запрос, удержанный блокировкой, - в held)
+#define TELEMETRY_FLAG_MIXING    0x10 // Мешалка работает
+
+/*
+ * Двоичная телеметрия через UART
+ * Реализует:
+ * - Кадры COBS: 0x00 встречается только как разделитель, поэтому приемник
+ *   находит начало кадра в любом месте потока, в том числе после текста консоли
+ * - CRC-16 (полином 0xA001, начальное значение 0xFFFF, как у SettingsStore)
+ *   в конце пакета, до кодирования
+ * - Отправку без ожидания: кадр кладется в буфер передачи Serial целиком
+ *   и только если там есть место, дальше его отправляет прерывание UDRE
+ *   HardwareSerial. Иначе кадр пропускается и учитывается в getDropped().
+ *   Кадр не перемешивается с выводом консоли: обе задачи пишут из главного цикла.
+ *
+ * Формат на линии: 0x00, COBS(пакет + CRC-16 младшим байтом вперед), 0x00.
+ * Разбор на компьютере: tools/telemetry_decode.py.
+ * Период задается -D TELEMETRY_INTERVAL=мс, выключенная при запуске
+ * телеметрия - -D TELEMETRY_ENABLED=0.
+ */
+#ifndef TELEMETRY_INTERVAL
+#define TELEMETRY_INTERVAL 1000
+#endif
+#ifndef TELEMETRY_ENABLED
+#define TELEMETRY_ENABLED 1
+#endif
+
+class Telemetry {
+public:
+    static const uint8_t PAYLOAD_SIZE = sizeof(TelemetryPacket) + 2;  // Пакет и CRC
+    static const uint8_t FRAME_SIZE = PAYLOAD_SIZE + 1 + 2;           // COBS и два разделителя
+    static const uint16_t INTERVAL = TELEMETRY_INTERVAL;              // Период отправки (мс)
+
+    static_assert(PAYLOAD_SIZE < 254, "Telemetry: COBS frame must fit one code block");
+    static_assert(FRAME_SIZE < SERIAL_TX_BUFFER_SIZE, "Telemetry: frame must fit the Serial TX buffer");
+
+    /*
+     * Включение и выключение потока пакетов
+     */
+    static void setEnabled(bool on) {
+        enabled = on;
+        lastSendTime = SystemTimer::getMillis() - INTERVAL; // Первый пакет - сразу
+    }
+
+    static bool isEnabled() {
+        return enabled;
+    }
+
+    /*
+     * Пора ли отправлять пакет (вызывается задачей телеметрии)
+     */
+    static bool isDue() {
+        return enabled && SystemTimer::getMillis() - lastSendTime >= INTERVAL;
+    }
+
+    /*
+     * Отправка пакета без ожидания
+     * packet - поля состояния; type, seq, uptime и время задач заполняются здесь
+     * Возвращает false, если в буфере передачи нет места под весь кадр
+     */
+    static bool send(HardwareSerial& port, TelemetryPacket& packet) {
+        lastSendTime = SystemTimer::getMillis();
+        packet.type = TELEMETRY_STATE;
+        packet.seq = seq++;
+        packet.uptime = lastSendTime;
+        fillTiming(packet);
+
+        if (port.availableForWrite() < FRAME_SIZE) {
+            if (dropped < 0xFFFF) dropped++;
+            return false;
+        }
+        uint8_t frame[FRAME_SIZE];
+        uint8_t length = encode(packet, frame);
+        port.write(frame, length);
+        return true;
+    }
+
+    /*
+     * Кадры, пропущенные из-за занятого буфера передачи
+     */
+    static uint16_t getDropped() {
+        return dropped;
+    }
+
+private:
+    static bool enabled;           // Поток пакетов включен
+    static uint32_t lastSendTime;  // Момент последней отправки (мс)
+    static uint8_t seq;            // Номер следующего пакета
+    static uint16_t dropped;       // Пропущенные кадры
+
+    /*
+     * Время задач планировщика: худшие значения с момента запуска
+     */
+    static void fillTiming(TelemetryPacket& packet) {
+        uint16_t maxLate = 0;
+        uint32_t overruns = 0;
+        for (uint8_t i = 0; i < TaskScheduler::getTaskCount(); i++) {
+            const Task& task = TaskScheduler::getTask(i);
+            if (task.maxLate > maxLate) maxLate = task.maxLate;
+            overruns += task.overruns;
+        }
+        packet.maxLate = maxLate;
+        packet.jitter = SystemTimer::getMaxJitterUs();
+        packet.overruns = (overruns > 0xFFFF) ? 0xFFFF : (uint16_t)overruns;
+    }
+
+    /*
+     * Кодирование кадра: разделитель, COBS(пакет + CRC), разделитель
+     * Возвращает длину кадра
+     */
+    static uint8_t encode(const TelemetryPacket& packet, uint8_t* frame) {
+        uint8_t payload[PAYLOAD_SIZE];
+        memcpy(payload, &packet, sizeof(packet));
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 0; i < sizeof(packet); i++) crc = _crc16_update(crc, payload[i]);
+        payload[sizeof(packet)] = crc & 0xFF;
+        payload[sizeof(packet) + 1] = crc >> 8;
+
+        // COBS: каждый ноль заменяется расстоянием до следующего нуля
+        uint8_t length = 0;
+        frame[length++] = 0x00;
+        uint8_t codeIndex = length++;
+        uint8_t code = 1;
+        for (uint8_t i = 0; i < PAYLOAD_SIZE; i++) {
+            if (payload[i] == 0) {
+                frame[codeIndex] = code;
+                codeIndex = length++;
+                code = 1;
+            } else {
+                frame[length++] = payload[i];
+                code++;
+            }
+        }
+        frame[codeIndex] = code;
+        frame[length++] = 0x00;
+        return length;
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    Telemetry() = delete;
+};
+
+bool Telemetry::enabled = TELEMETRY_ENABLED;
+uint32_t Telemetry::lastSendTime = 0;
+uint8_t Telemetry::seq = 0;
+uint16_t Telemetry::dropped = 0;
@@ -0,0 +1,96 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * Фильтр температуры с фиксированным шагом дискретизации
+ * Реализует:
+ * - Медианный фильтр по MEDIAN_SIZE последним отсчетам (подавление одиночных выбросов)
+ * - БИХ-фильтр первого порядка в фиксированной точке (Q16), без float
+ * - Настройку постоянной времени в секундах, а не сырым коэффициентом alpha
+ *
+ * Фильтр рассчитан на вызов push() строго раз в SAMPLE_PERIOD_MS миллисекунд.
+ * Тактированием занимается владелец (TemperatureSensor), поэтому запаздывание
+ * фильтра не зависит от скорости главного цикла.
+ * Значения - температура в сотых долях градуса.
+ */
+class TempFilter {
+public:
+    static const uint16_t SAMPLE_PERIOD_MS = 100; // Шаг дискретизации фильтра (мс)
+    static const uint8_t MEDIAN_SIZE = 5;         // Окно медианного фильтра (нечетное)
+
+    /*
+     * Конструктор
+     * timeConstantSec - постоянная времени БИХ-фильтра (сек), 0 - без сглаживания
+     */
+    TempFilter(uint16_t timeConstantSec)
+        : coefficient(calculateCoefficient(timeConstantSec)),
+          accumulator(0), windowIndex(0)
+    {
+        memset(window, 0, sizeof(window));
+    }
+
+    /*
+     * Сброс фильтра к заданному значению (первое измерение, смена датчика)
+     */
+    void reset(int16_t value) {
+        for (uint8_t i = 0; i < MEDIAN_SIZE; i++) {
+            window[i] = value;
+        }
+        accumulator = (int32_t)value << 16;
+    }
+
+    /*
+     * Добавление очередного отсчета
+     * sample - температура в сотых долях градуса
+     */
+    void push(int16_t sample) {
+        window[windowIndex] = sample;
+        if (++windowIndex >= MEDIAN_SIZE) windowIndex = 0;
+
+        // y += alpha * (median - y); разность ограничивается до int16,
+        // чтобы произведение на alpha (<= 0.5 в Q16) помещалось в int32
+        int32_t diff = (int32_t)median() - value();
+        diff = constrain(diff, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+        accumulator += (int32_t)(int16_t)diff * coefficient;
+    }
+
+    /*
+     * Текущее отфильтрованное значение (сотые доли градуса)
+     */
+    int16_t value() const {
+        return (int16_t)((accumulator + 0x8000L) >> 16);
+    }
+
+private:
+    const uint16_t coefficient;         // alpha в формате Q16
+    int32_t accumulator;                // Состояние фильтра в формате Q16
+    int16_t window[MEDIAN_SIZE];        // Последние отсчеты для медианы
+    uint8_t windowIndex;                // Позиция записи в окне
+
+    /*
+     * Расчет alpha = dt / (tau + dt) в формате Q16
+     * При tau = 0 alpha = 0.5 (максимум, при котором не переполняется умножение)
+     */
+    static uint16_t calculateCoefficient(uint16_t timeConstantSec) {
+        uint32_t tauMs = (uint32_t)timeConstantSec * 1000UL;
+        if (tauMs < SAMPLE_PERIOD_MS) tauMs = SAMPLE_PERIOD_MS;
+        return (uint16_t)((65536UL * SAMPLE_PERIOD_MS) / (tauMs + SAMPLE_PERIOD_MS));
+    }
+
+    /*
+     * Медиана окна (сортировка вставками копии из MEDIAN_SIZE элементов)
+     */
+    int16_t median() const {
+        int16_t sorted[MEDIAN_SIZE];
+        for (uint8_t i = 0; i < MEDIAN_SIZE; i++) {
+            int16_t v = window[i];
+            uint8_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        return sorted[MEDIAN_SIZE / 2];
+    }
+};
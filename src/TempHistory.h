@@ -0,0 +1,233 @@
+#pragma once
+#include <Arduino.h>
+#include "Format.h"
+#include "SystemTimer.h"
+
+/*
+ * История температуры регулирования в RAM
+ * Реализует:
+ * - Последний час с шагом 10 с: 4-битные приращения по 0.05 °C
+ *   относительно предыдущего восстановленного значения, две точки в байте
+ * - Последние 8 часов по 5 минут: минимум, среднее и максимум в 2 байтах
+ * - Пропуски при неисправном датчике (значение не теряет привязку)
+ * - Выгрузку всей истории в Serial от старых точек к новым
+ *
+ * Кодер приращений следит за восстановленным значением, а не за измеренным:
+ * ошибка округления и насыщения (быстрее 0.35 °C за 10 с, т.е. 2.1 °C/мин)
+ * не накапливается и выбирается следующими точками.
+ * Интервал 5 минут хранит среднее с шагом 0.5 °C и отклонения минимума
+ * и максимума от среднего (полубайты, шаг 0.5 °C, до 7.5 °C).
+ *
+ * RAM: 180 + 2 * 96 байт и 26 байт состояния. Глубина грубой истории
+ * задается -D TEMP_HISTORY_COARSE_SLOTS=интервалов (288 - сутки, +384 байта),
+ * вся история отключается сборкой с -D TEMP_HISTORY=0.
+ */
+#ifndef TEMP_HISTORY
+#define TEMP_HISTORY 1
+#endif
+#ifndef TEMP_HISTORY_COARSE_SLOTS
+#define TEMP_HISTORY_COARSE_SLOTS 96
+#endif
+
+class TempHistory {
+public:
+    static const uint32_t SAMPLE_PERIOD_MS = 10000UL; // Шаг точной истории
+    static const uint16_t FINE_SLOTS = 360;           // Точек точной истории (1 час)
+    static const uint8_t SAMPLES_PER_BUCKET = 30;     // Точек в интервале (5 минут)
+    static const uint16_t COARSE_SLOTS = TEMP_HISTORY_COARSE_SLOTS; // Интервалов (96 - 8 часов)
+
+    /*
+     * Учет температуры (можно вызывать на каждом запуске задачи)
+     * Точка берется раз в SAMPLE_PERIOD_MS
+     * valid - датчик исправен, centi - температура в сотых долях градуса
+     */
+    static void update(bool valid, int16_t centi) {
+        uint32_t now = SystemTimer::getMillis();
+        if (started && now - lastSampleTime < SAMPLE_PERIOD_MS) return;
+        // Без накопления ухода шага; после долгой задержки отсчет начинается заново
+        lastSampleTime = (started && now - lastSampleTime < 2 * SAMPLE_PERIOD_MS)
+                         ? lastSampleTime + SAMPLE_PERIOD_MS : now;
+        started = true;
+        addFine(valid, centi);
+        addCoarse(valid, centi);
+    }
+
+    /*
+     * Выгрузка истории в Serial
+     * age_s - возраст точки (для интервала - его начала) относительно последней точки;
+     * "-" - нет данных
+     */
+    static void print(Print& out) {
+        char buffer[8];
+        out.println(F("history 10s: age_s temp_c"));
+        // Значение самой старой точки: от последнего значения назад по приращениям
+        uint16_t index = slot(fineHead, fineCount, FINE_SLOTS);
+        int16_t value = fineValue;
+        for (uint16_t n = 1; n < fineCount; n++) {
+            value -= delta(readFine((index + n) % FINE_SLOTS));
+        }
+        for (uint16_t n = 0; n < fineCount; n++) {
+            int8_t d = readFine((index + n) % FINE_SLOTS);
+            if (n > 0) value += delta(d);
+            out.print((uint32_t)(fineCount - 1 - n) * (SAMPLE_PERIOD_MS / 1000));
+            out.print(' ');
+            if (d == FINE_NO_DATA) {
+                out.println('-');
+            } else {
+                Format::fixed(buffer, value, 2);
+                out.println(buffer);
+            }
+        }
+
+        out.println(F("history 5min: age_s min avg max"));
+        index = slot(coarseHead, coarseCount, COARSE_SLOTS);
+        for (uint16_t n = 0; n < coarseCount; n++) {
+            const Bucket& bucket = coarse[(index + n) % COARSE_SLOTS];
+            out.print(((uint32_t)(coarseCount - n) * SAMPLES_PER_BUCKET + bucketSamples - 1) *
+                      (SAMPLE_PERIOD_MS / 1000));
+            if (bucket.average == NO_DATA) {
+                out.println(F(" - - -"));
+                continue;
+            }
+            // Полградуса -> десятые доли
+            int16_t average = bucket.average * 5;
+            out.print(' ');
+            Format::fixed(buffer, average - (bucket.spread >> 4) * 5, 1);
+            out.print(buffer);
+            out.print(' ');
+            Format::fixed(buffer, average, 1);
+            out.print(buffer);
+            out.print(' ');
+            Format::fixed(buffer, average + (bucket.spread & 0x0F) * 5, 1);
+            out.println(buffer);
+        }
+    }
+
+private:
+    static const int8_t NO_DATA = -128;  // Маркер интервала без данных
+    static const int8_t FINE_NO_DATA = -8; // Маркер пропущенной точки (полубайт 0x8)
+    static const int8_t FINE_MAX = 7;    // Наибольшее приращение (шагов)
+    static const uint8_t FINE_STEP = 5;  // Шаг приращения (сотые доли °C)
+
+    static_assert(FINE_SLOTS % 2 == 0, "TempHistory: FINE_SLOTS must be even (two points per byte)");
+    static const uint8_t COARSE_STEP = 50; // Шаг среднего и отклонений (сотые доли °C)
+
+    // Интервал 5 минут
+    struct Bucket {
+        int8_t average; // Среднее (шаг 0.5 °C), NO_DATA - нет исправных точек
+        uint8_t spread; // Старший полубайт - среднее минус минимум, младший - максимум минус среднее
+    };
+
+    static uint8_t fine[FINE_SLOTS / 2]; // Приращения точной истории (младший полубайт - четная точка)
+    static uint16_t fineHead;           // Ячейка следующей точки
+    static uint16_t fineCount;          // Заполненных ячеек
+    static int16_t fineValue;           // Восстановленное значение последней точки
+    static bool hasValue;               // fineValue задано первым исправным измерением
+    static Bucket coarse[COARSE_SLOTS]; // Интервалы по 5 минут
+    static uint16_t coarseHead;
+    static uint16_t coarseCount;
+    static int32_t bucketSum;           // Сумма исправных точек текущего интервала
+    static int16_t bucketMin;
+    static int16_t bucketMax;
+    static uint8_t bucketValid;         // Исправных точек в текущем интервале
+    static uint8_t bucketSamples;       // Всех точек в текущем интервале
+    static uint32_t lastSampleTime;     // Момент последней точки (мс)
+    static bool started;                // Первая точка взята
+
+    /*
+     * Номер самой старой ячейки кольца
+     */
+    static uint16_t slot(uint16_t head, uint16_t count, uint16_t size) {
+        return (head + size - count) % size;
+    }
+
+    static int16_t delta(int8_t d) {
+        return (d == FINE_NO_DATA) ? 0 : d * FINE_STEP;
+    }
+
+    /*
+     * Чтение и запись 4-битного приращения со знаком
+     */
+    static int8_t readFine(uint16_t index) {
+        uint8_t nibble = (index & 1) ? fine[index >> 1] >> 4 : fine[index >> 1] & 0x0F;
+        return (nibble & 0x08) ? (int8_t)nibble - 16 : (int8_t)nibble;
+    }
+
+    static void writeFine(uint16_t index, int8_t d) {
+        uint8_t& cell = fine[index >> 1];
+        cell = (index & 1) ? (cell & 0x0F) | ((d & 0x0F) << 4) : (cell & 0xF0) | (d & 0x0F);
+    }
+
+    /*
+     * Деление с округлением от нуля
+     */
+    static int16_t divideRounded(int32_t value, uint8_t step) {
+        return (value >= 0) ? (value + step / 2) / step : -((-value + step / 2) / step);
+    }
+
+    static void addFine(bool valid, int16_t centi) {
+        int8_t d = FINE_NO_DATA;
+        if (valid) {
+            if (!hasValue) {
+                fineValue = centi;
+                hasValue = true;
+            }
+            int16_t steps = divideRounded((int32_t)centi - fineValue, FINE_STEP);
+            d = (steps > FINE_MAX) ? FINE_MAX : (steps < -FINE_MAX) ? -FINE_MAX : steps;
+            fineValue += d * FINE_STEP;
+        }
+        writeFine(fineHead, d);
+        fineHead = (fineHead + 1) % FINE_SLOTS;
+        if (fineCount < FINE_SLOTS) fineCount++;
+    }
+
+    static void addCoarse(bool valid, int16_t centi) {
+        if (valid) {
+            if (bucketValid == 0 || centi < bucketMin) bucketMin = centi;
+            if (bucketValid == 0 || centi > bucketMax) bucketMax = centi;
+            bucketSum += centi;
+            bucketValid++;
+        }
+        if (++bucketSamples < SAMPLES_PER_BUCKET) return;
+
+        Bucket& bucket = coarse[coarseHead];
+        bucket.average = NO_DATA;
+        bucket.spread = 0;
+        if (bucketValid != 0) {
+            int16_t average = divideRounded(divideRounded(bucketSum, bucketValid), COARSE_STEP);
+            average = (average > 127) ? 127 : (average < -127) ? -127 : average;
+            // Отклонения округляются вверх: диапазон накрывает все точки (до насыщения)
+            int16_t center = average * COARSE_STEP;
+            int16_t low = (center - bucketMin + COARSE_STEP - 1) / COARSE_STEP;
+            int16_t high = (bucketMax - center + COARSE_STEP - 1) / COARSE_STEP;
+            low = (low < 0) ? 0 : (low > 15) ? 15 : low;
+            high = (high < 0) ? 0 : (high > 15) ? 15 : high;
+            bucket.average = average;
+            bucket.spread = (low << 4) | high;
+        }
+        coarseHead = (coarseHead + 1) % COARSE_SLOTS;
+        if (coarseCount < COARSE_SLOTS) coarseCount++;
+        bucketSum = 0;
+        bucketValid = 0;
+        bucketSamples = 0;
+    }
+
+    // Запрещаем создание экземпляров класса, так как это статический класс
+    TempHistory() = delete;
+};
+
+uint8_t TempHistory::fine[TempHistory::FINE_SLOTS / 2];
+uint16_t TempHistory::fineHead = 0;
+uint16_t TempHistory::fineCount = 0;
+int16_t TempHistory::fineValue = 0;
+bool TempHistory::hasValue = false;
+TempHistory::Bucket TempHistory::coarse[TempHistory::COARSE_SLOTS];
+uint16_t TempHistory::coarseHead = 0;
+uint16_t TempHistory::coarseCount = 0;
+int32_t TempHistory::bucketSum = 0;
+int16_t TempHistory::bucketMin = 0;
+int16_t TempHistory::bucketMax = 0;
+uint8_t TempHistory::bucketValid = 0;
+uint8_t TempHistory::bucketSamples = 0;
+uint32_t TempHistory::lastSampleTime = 0;
+bool TempHistory::started = false;
@@ -1,46 +1,117 @@
 #pragma once
 #include <GyverNTC.h> // Библиотека для работы с NTC-термисторами
 #include <Arduino.h>  // Для constrain()
+#include "AdcSampler.h" // Фоновый опрос АЦП по прерыванию
+#include "NtcTable.h"   // Табличный пересчет кода АЦП в температуру
+#include "TempFilter.h" // Фильтр с фиксированным шагом дискретизации
+
+// Параметры термистора и делителя
+#define NTC_SERIES_R 10000 // Сопротивление делителя напряжения (Ом)
+#define NTC_BETA 3950      // B-коэффициент термистора (указывается в спецификации термистора)
+
+// Способ пересчета: 1 - таблица в PROGMEM (десятки тактов), 0 - расчет GyverNTC с log()
+#ifndef NTC_USE_LOOKUP_TABLE
+#define NTC_USE_LOOKUP_TABLE 1
+#endif
+
+typedef NtcTable<NTC_SERIES_R, NTC_BETA> NtcLookup;
 
 /*
  * Класс для работы с датчиком температуры
  * Реализует:
- * - Сглаживание показаний с помощью экспоненциального скользящего среднего
+ * - Чтение уже усредненного кода АЦП из AdcSampler (без блокирующего analogRead)
+ * - Пересчет кода в температуру по таблице NtcLookup или через GyverNTC
+ * - Фильтрацию TempFilter с фиксированным шагом SAMPLE_PERIOD_MS (медиана + БИХ)
  * - Проверку исправности датчика (выход за допустимый диапазон)
  * - Калибровку показаний
+ *
+ * Внутри все значения хранятся в сотых долях градуса (int16_t).
  */
 class TemperatureSensor {
 private:
+    static const uint8_t MAX_CATCHUP_SAMPLES = 50; // Макс. число пропущенных шагов, догоняемых за раз (5 с)
+
+#if !NTC_USE_LOOKUP_TABLE
     GyverNTC ntc;                  // Объект датчика NTC-термистора
-    float filteredTemp;            // Отфильтрованное значение температуры
-    const float alpha;             // Коэффициент фильтра (0.0-1.0), определяет степень сглаживания
-    float calibrationOffset;       // Калибровочное смещение
-    const float one_minus_alpha;   // 1 - alpha (для оптимизации вычислений)
+#endif
+    TempFilter filter;             // Фильтр с фиксированным шагом дискретизации
+    int16_t calibrationOffset;     // Калибровочное смещение (сотые доли °C)
+    const uint8_t channel;         // Номер канала AdcSampler
+    bool primed;                   // Фильтр инициализирован первым измерением
+    unsigned long lastSampleTime;  // Время последнего шага фильтра (мс)
 
 public:
     /*
      * Конструктор
-     * pin - аналоговый пин, к которому подключен термистор
-     * R - сопротивление делителя напряжения (обычно 10 кОм)
-     * B - B-коэффициент термистора (указывается в спецификации термистора)
-     * a - коэффициент фильтрации (0.0-1.0), рекомендуется 0.01f - 0.3f
+     * adcChannel - номер канала AdcSampler, к которому подключен термистор
+     * timeConstantSec - постоянная времени сглаживания (сек)
+     * Параметры термистора задаются макросами NTC_SERIES_R и NTC_BETA,
+     * так как по ним на этапе компиляции строится таблица пересчета.
      */
-    TemperatureSensor(uint8_t pin, int R = 10000, int B = 3950, float a = 0.1f) 
-        : ntc(pin, R, B), 
-          filteredTemp(0.0f), 
-          alpha(constrain(a, 0.01f, 0.3f)), // Ограничиваем alpha в разумных пределах
-          calibrationOffset(0.0f),
-          one_minus_alpha(1.0f - alpha) 
+    TemperatureSensor(uint8_t adcChannel, uint16_t timeConstantSec = 5) 
+        :
+#if !NTC_USE_LOOKUP_TABLE
+          ntc(A0, NTC_SERIES_R, NTC_BETA), // Пин не используется: код АЦП приходит из AdcSampler
+#endif
+          filter(timeConstantSec),
+          calibrationOffset(0),
+          channel(adcChannel),
+          primed(false),
+          lastSampleTime(0)
     {}
 
+    /*
+     * Пересчет кода АЦП (разрядность AdcSampler::RESULT_BITS) в температуру
+     * Возвращает температуру в сотых долях градуса
+     */
+    int16_t convert(uint16_t code) {
+#if NTC_USE_LOOKUP_TABLE
+        return NtcLookup::convert(code);
+#else
+        // Переводим 12-битный код обратно в шкалу 10 бит, сохраняя дробную часть
+        float temp = ntc.computeTemp(code * (1.0f / (1 << AdcSampler::OVERSAMPLE_BITS)));
+        return (int16_t)constrain(temp * 100.0f, (float)NtcLookup::TEMP_MIN, (float)NtcLookup::TEMP_MAX);
+#endif
+    }
+
     /*
      * Обновление показаний датчика
-     * Должно вызываться регулярно (например, в loop()), чтобы получать актуальные данные
+     * Может вызываться с любой частотой: фильтр получает ровно один отсчет
+     * на каждые SAMPLE_PERIOD_MS миллисекунд, пропущенные шаги догоняются.
      */
     void update() {
-        float rawTemp = ntc.getTemp(); 
-        // Применение экспоненциального скользящего среднего для сглаживания
-        filteredTemp = alpha * rawTemp + one_minus_alpha * filteredTemp;
+        if (!AdcSampler::isReady(channel)) return; // Буфер АЦП еще не заполнен
+
+        unsigned long now = millis();
+        if (now - lastSampleTime < TempFilter::SAMPLE_PERIOD_MS && primed) return;
+
+        int16_t rawTemp = convert(AdcSampler::read(channel));
+        if (!primed) {
+            filter.reset(rawTemp); // Первое измерение - без сглаживания
+            lastSampleTime = now;
+            primed = true;
+            return;
+        }
+
+        // Отсчет АЦП считается неизменным на всем пропущенном интервале
+        uint8_t steps = 0;
+        while (now - lastSampleTime >= TempFilter::SAMPLE_PERIOD_MS && steps < MAX_CATCHUP_SAMPLES) {
+            filter.push(rawTemp);
+            lastSampleTime += TempFilter::SAMPLE_PERIOD_MS;
+            steps++;
+        }
+        // Слишком долгая пауза - синхронизируем часы фильтра с текущим временем
+        if (now - lastSampleTime >= TempFilter::SAMPLE_PERIOD_MS) {
+            lastSampleTime = now;
+        }
+    }
+
+    /*
+     * Получение текущей температуры с учетом калибровки
+     * Возвращает температуру в сотых долях градуса
+     */
+    int16_t getTempCenti() const {
+        return filter.value() + calibrationOffset;
     }
 
     /*
@@ -48,7 +119,14 @@ public:
      * Возвращает температуру в градусах Цельсия (°C)
      */
     float getTemp() const { 
-        return filteredTemp + calibrationOffset; 
+        return getTempCenti() * 0.01f; 
+    }
+
+    /*
+     * Есть ли уже первое измерение
+     */
+    bool hasReading() const {
+        return primed;
     }
 
     /*
@@ -56,10 +134,13 @@ public:
      * Возвращает false, если отфильтрованное показание температуры выходит
      * за заведомо нереалистичные пределы (-50°C до 150°C), что может указывать
      * на обрыв или короткое замыкание датчика.
+     * До первого измерения датчик также считается неисправным.
      */
     bool isSensorOK() const {
+        if (!primed) return false;
         // Проверяем, находится ли температура в разумном диапазоне
-        return !(filteredTemp <= -50.0f || filteredTemp >= 150.0f);
+        int16_t temp = filter.value();
+        return !(temp <= -5000 || temp >= 15000);
     }
 
     /*
@@ -68,6 +149,18 @@ public:
      */
     void calibrate(float referenceTemp) {
         // Рассчитываем смещение между эталонной и измеренной температурой
-        calibrationOffset = referenceTemp - filteredTemp;
+        calibrationOffset = (int16_t)(referenceTemp * 100.0f) - filter.value();
+    }
+
+    /*
+     * Получение и установка калибровочного смещения (сотые доли °C)
+     * Используются для сохранения калибровки в EEPROM
+     */
+    int16_t getCalibration() const {
+        return calibrationOffset;
+    }
+
+    void setCalibration(int16_t offset) {
+        calibrationOffset = offset;
     }
 };
@@ -0,0 +1,147 @@
+#pragma once
+#include <Arduino.h>
+#include <util/crc16.h> // Для _crc8_ccitt_update
+#include "EEPROMStorage.h"
+
+/*
+ * Запись журнала мойки (8 байт)
+ * stage == 0 - мойка не выполняется (завершена или остановлена)
+ */
+struct WashJournalRecord {
+    uint8_t seq;        // Порядковый номер записи (по модулю 256)
+    uint8_t recipe;     // Рецепт (RecipeId)
+    uint8_t stage;      // Текущий шаг (1..N), 0 - мойка не активна
+    uint8_t flags;      // Флаги WASH_JOURNAL_*
+    uint16_t elapsed;   // Время от начала шага или ожидания температуры (сек)
+    uint8_t reserved;   // Резерв (0)
+    uint8_t crc;        // CRC-8 первых 7 байт
+} __attribute__((packed));
+
+#define WASH_JOURNAL_WAITING 0x01   // Шаг ждал температуру
+#define WASH_JOURNAL_TEMP_FAULT 0x02 // В мойке уже была ошибка по температуре
+
+/*
+ * Журнал мойки в EEPROM
+ * Реализует:
+ * - Кольцо из SLOTS записей: каждая новая запись пишется в следующую ячейку,
+ *   поэтому износ распределяется по всему кольцу
+ * - Устойчивость к пропаданию питания: запись с неверной CRC (прерванная
+ *   на середине) игнорируется, действует предыдущая
+ * - Поиск последней записи при старте по непрерывности номеров
+ *
+ * Номер записи однозначно задает ячейку (seq % SLOTS), поэтому последняя
+ * запись - та, за которой в следующей ячейке нет записи с номером seq + 1.
+ *
+ * Оценка износа: запись делается при смене шага и раз в CHECKPOINT_INTERVAL_MS.
+ * Полная мойка (5 шагов, 7 минут) - около 13 записей; 5 моек в день -
+ * 65 записей, т.е. около 4 перезаписей каждой ячейки кольца в день.
+ * Ресурс EEPROM 100 000 циклов хватает на десятки лет.
+ */
+class WashJournal {
+public:
+    static const uint8_t SLOTS = 16; // Записей в кольце (делитель 256)
+    static const uint32_t CHECKPOINT_INTERVAL_MS = 60000UL; // Период сохранения прогресса шага
+    static const int SIZE = SLOTS * sizeof(WashJournalRecord); // Размер области в EEPROM
+
+private:
+    static_assert(256 % SLOTS == 0, "WashJournal: SLOTS must divide 256");
+    static_assert(sizeof(WashJournalRecord) <= EEPROMStorage::QUEUE_BLOCK_SIZE,
+                  "WashJournal: record must fit an EEPROMStorage queue block");
+
+    const int baseAddress;    // Начало кольца в EEPROM
+    WashJournalRecord head;   // Последняя действительная запись
+    bool headValid;           // Журнал содержит хотя бы одну запись
+
+    /*
+     * CRC-8 (CCITT) записи без последнего байта
+     * Начальное значение 0xFF: стертая (0xFF) и обнуленная EEPROM не дают верной записи
+     */
+    static uint8_t calculateCrc(const WashJournalRecord& record) {
+        uint8_t crc = 0xFF;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&record);
+        for (size_t i = 0; i < sizeof(record) - 1; i++) {
+            crc = _crc8_ccitt_update(crc, p[i]);
+        }
+        return crc;
+    }
+
+    int slotAddress(uint8_t slot) const {
+        return baseAddress + slot * sizeof(WashJournalRecord);
+    }
+
+    /*
+     * Чтение ячейки; возвращает true, если запись в ней действительна
+     */
+    bool readSlot(uint8_t slot, WashJournalRecord& record) const {
+        EEPROMStorage::read(slotAddress(slot), record);
+        return record.crc == calculateCrc(record) && record.seq % SLOTS == slot;
+    }
+
+public:
+    /*
+     * Конструктор
+     * eepromAddress - начало области журнала (SIZE байт)
+     */
+    explicit WashJournal(int eepromAddress)
+        : baseAddress(eepromAddress), head(), headValid(false)
+    {}
+
+    /*
+     * Поиск последней записи (вызывать из setup())
+     */
+    void begin() {
+        headValid = false;
+        for (uint8_t slot = 0; slot < SLOTS; slot++) {
+            WashJournalRecord record;
+            if (!readSlot(slot, record)) continue;
+
+            WashJournalRecord next;
+            uint8_t nextSlot = (slot + 1) % SLOTS;
+            if (readSlot(nextSlot, next) && next.seq == (uint8_t)(record.seq + 1)) {
+                continue; // За этой записью есть более новая
+            }
+            head = record;
+            headValid = true;
+            return;
+        }
+    }
+
+    /*
+     * Добавление записи в следующую ячейку кольца (только из главного цикла)
+     * Запись ставится в очередь фоновой записи EEPROMStorage, без ожидания
+     * Возвращает false, если очередь заполнена: запись не сделана, повторить позже
+     */
+    bool append(uint8_t recipe, uint8_t stage, uint8_t flags, uint16_t elapsed) {
+        WashJournalRecord record;
+        record.seq = headValid ? (uint8_t)(head.seq + 1) : 0;
+        record.recipe = recipe;
+        record.stage = stage;
+        record.flags = flags;
+        record.elapsed = elapsed;
+        record.reserved = 0;
+        record.crc = calculateCrc(record);
+        if (!EEPROMStorage::writeAsync(slotAddress(record.seq % SLOTS), &record, sizeof(record))) {
+            return false;
+        }
+        head = record;
+        headValid = true;
+        return true;
+    }
+
+    /*
+     * Последняя запись журнала
+     * Возвращает false, если журнал пуст
+     */
+    bool last(WashJournalRecord& record) const {
+        if (!headValid) return false;
+        record = head;
+        return true;
+    }
+
+    /*
+     * Проверка, была ли мойка прервана (последняя запись - активный шаг)
+     */
+    bool isInterrupted() const {
+        return headValid && head.stage != 0;
+    }
+};
@@ -1,189 +1,411 @@
 #pragma once
-#include "EEPROMStorage.h"
-#include <Arduino.h> // Добавлено для pinMode/digitalWrite
+#include "SettingsStore.h"
+#include "TemperatureSensor.h"
+#include "OutputBank.h"
+#include "Recipe.h"
+#include "SystemTimer.h"
+#include "WashJournal.h"
+#include "EventLog.h"
+#include <Arduino.h>
 
 /*
  * Структура настроек мойки
  */
 struct WashingSettings {
-    uint16_t stageTimes[5] = {60, 120, 60, 120, 60}; // Времена этапов (сек)
-    uint8_t checksum = 0; // Контрольная сумма
+    uint8_t recipe = RECIPE_CUSTOM;                // Выбранный рецепт (RecipeId)
+    uint8_t customStepCount = 0;                   // Количество шагов пользовательского рецепта
+    RecipeStep customSteps[RECIPE_MAX_STEPS] = {}; // Шаги пользовательского рецепта
 } __attribute__((packed));
 
 /*
  * Класс для управления системой мойки
  * Реализует:
- * - Автоматическую многоэтапную мойку
+ * - Автоматическую многоэтапную мойку по рецепту (см. Recipe.h)
+ * - Ожидание температуры в обратной линии перед отсчетом шага
+ * - Паузу отсчета шага, пока блокировка OutputBank удерживает его выход
+ * - Переключение шагов по аппаратному дедлайну SystemTimer (Timer1):
+ *   выходы следующего шага включаются из прерывания в миллисекунду дедлайна,
+ *   даже если главный цикл в этот момент заблокирован
+ * - Журнал хода мойки в EEPROM (WashJournal): смена шагов и периодические
+ *   отметки прогресса; после сброса мойку можно продолжить или вымыть химию
  * - Управление клапанами и насосами
- * - Сохранение настроек в EEPROM
+ * - Сохранение настроек и пользовательского рецепта в EEPROM
  * - Ручное управление компонентами
  */
 class WashingController {
 private:
-    // Пины управления
-    const uint8_t drainValvePin;
-    const uint8_t coldWaterValvePin;
-    const uint8_t hotWaterValvePin;
-    const uint8_t washPumpPin;
-    const uint8_t alkaliPumpPin;
-    const uint8_t acidPumpPin;
-    
+    TemperatureSensor& returnSensor; // Датчик обратной линии мойки
+
+    OutputBank& outputs;            // Банк выходов (клапаны и насосы - OUT_WASH_GROUP)
+    WashJournal& journal;           // Журнал хода мойки
+
     WashingSettings settings;       // Текущие настройки
-    volatile bool washingRunning;   // Флаг работы мойки (volatile для прерываний)
-    uint8_t currentStage;           // Текущий этап (0 - не активен)
-    unsigned long stageStartTime;   // Время начала этапа
+    bool washingRunning;            // Флаг работы мойки
+    uint8_t activeRecipe;           // Рецепт, по которому идет мойка
+    uint8_t currentStage;           // Текущий шаг (1..N, 0 - не активен)
+    RecipeStep step;                // Копия текущего шага в RAM
+    uint32_t stageStartTime;        // Время начала отсчета шага (SystemTimer::getMillis())
+    bool waitingForTemp;            // Шаг ждет нужной температуры
+    bool tempFault;                 // Температура не была достигнута за таймаут
+    bool stalled;                   // Выход шага удержан блокировкой, отсчет стоит
+    uint32_t stallStart;            // Момент начала паузы
+    uint8_t pendingOutputs;         // Выходы, включаемые по дедлайну
+    volatile bool deadlineFired;    // Дедлайн сработал, учет шага еще не выполнен
+    volatile uint32_t deadlineTime; // Момент срабатывания дедлайна
+    bool journalPending;            // Состояние изменилось, запись в журнал еще не сделана
+    uint32_t lastCheckpoint;        // Время последней записи в журнал
+
+    /*
+     * Пользовательский рецепт по умолчанию - копия полной мойки
+     * Остальные ячейки - холодное ополаскивание без условия по температуре,
+     * чтобы увеличение числа шагов в меню не добавляло пустых шагов
+     */
+    void resetCustomRecipe() {
+        uint8_t count = pgm_read_byte(&builtinRecipes[RECIPE_FULL_CIP].stepCount);
+        settings.customStepCount = count;
+        memcpy_P(settings.customSteps, recipeFullCip, count * sizeof(RecipeStep));
+        for (uint8_t i = count; i < RECIPE_MAX_STEPS; i++) {
+            settings.customSteps[i] = {STEP_COLD_RINSE, OUT_DRAIN_VALVE | OUT_COLD_WATER, 60,
+                                       RECIPE_NO_TEMP, 0};
+        }
+    }
+
+    /*
+     * Загрузка шага рецепта в RAM
+     * index - номер шага (с нуля)
+     */
+    void loadStep(uint8_t recipe, uint8_t index) {
+        loadStepInto(step, recipe, index);
+    }
+
+    void loadStepInto(RecipeStep& target, uint8_t recipe, uint8_t index) const {
+        if (recipe == RECIPE_CUSTOM) {
+            target = settings.customSteps[index];
+        } else {
+            const RecipeStep* steps =
+                (const RecipeStep*)pgm_read_ptr(&builtinRecipes[recipe].steps);
+            memcpy_P(&target, &steps[index], sizeof(RecipeStep));
+        }
+    }
 
-    // Названия этапов в PROGMEM
-    static const char* const stageNames[6] PROGMEM;
+    /*
+     * Активация шага мойки
+     * stage - номер шага (1..N)
+     * startTime - момент начала шага
+     * Новая комбинация клапанов и насосов применяется одной записью,
+     * без промежуточного выключения всех устройств.
+     */
+    void activateStage(uint8_t stage, uint32_t startTime) {
+        loadStep(activeRecipe, stage - 1);
+        stageStartTime = startTime;
+        stalled = false;
+        waitingForTemp = (step.minTemp != RECIPE_NO_TEMP);
+        outputs.apply(OUT_WASH_GROUP, step.outputs);
+        armStageDeadline();
+        journalPending = true;
+    }
+
+    /*
+     * Запуск мойки с указанного шага
+     */
+    void beginRecipe(uint8_t recipe, uint8_t stage, uint32_t startTime) {
+        washingRunning = true;
+        activeRecipe = recipe;
+        tempFault = false;
+        deadlineFired = false;
+        currentStage = stage;
+        activateStage(currentStage, startTime);
+        EventLog::append(LOG_WASH_START, recipe);
+    }
+
+    /*
+     * Запись текущего состояния в журнал
+     * Запись уходит в очередь EEPROM; если очередь занята, повторяется
+     * на следующем запуске update()
+     */
+    void writeJournal() {
+        uint32_t now = SystemTimer::getMillis();
+        uint8_t flags = 0;
+        uint16_t elapsed = 0;
+        if (washingRunning) {
+            if (waitingForTemp) flags |= WASH_JOURNAL_WAITING;
+            if (tempFault) flags |= WASH_JOURNAL_TEMP_FAULT;
+            uint32_t seconds = stageElapsed() / 1000UL;
+            elapsed = (seconds > 0xFFFF) ? 0xFFFF : (uint16_t)seconds;
+        }
+        if (journal.append(activeRecipe, washingRunning ? currentStage : 0, flags, elapsed)) {
+            lastCheckpoint = now;
+        } else {
+            journalPending = true;
+        }
+    }
 
     /*
-     * Расчет контрольной суммы
+     * Назначение дедлайна текущего шага
+     * Без условия по температуре - конец шага; при ожидании температуры -
+     * таймаут ожидания (если задан). К дедлайну заранее готовятся выходы
+     * следующего шага (или 0, если шаг последний).
      */
-    uint8_t calculateChecksum() const {
-        uint8_t sum = 0;
-        const uint8_t* data = reinterpret_cast<const uint8_t*>(&settings);
-        for(size_t i = 0; i < sizeof(settings) - 1; i++) {
-            sum += data[i];
+    void armStageDeadline() {
+        uint32_t length;
+        if (waitingForTemp) {
+            if (step.timeout == 0) {
+                SystemTimer::disarm(); // Ждем температуру без ограничения
+                return;
+            }
+            length = (uint32_t)step.timeout * 1000UL;
+        } else {
+            length = (uint32_t)step.duration * 1000UL;
+        }
+
+        if (currentStage < getStepCount(activeRecipe)) {
+            RecipeStep next;
+            loadStepInto(next, activeRecipe, currentStage);
+            pendingOutputs = next.outputs;
+        } else {
+            pendingOutputs = 0;
         }
-        return ~sum; // Инвертированная сумма
+        SystemTimer::arm(stageStartTime + length, onStageDeadline, this);
     }
 
     /*
-     * Активация этапа мойки
-     * stage - номер этапа (1-5)
+     * Время от начала отсчета шага без пауз (мс)
      */
-    void activateStage(uint8_t stage) {
-        // Выключение всех устройств перед активацией нового этапа
-        digitalWrite(drainValvePin, LOW);
-        digitalWrite(coldWaterValvePin, LOW);
-        digitalWrite(hotWaterValvePin, LOW);
-        digitalWrite(washPumpPin, LOW);
-        digitalWrite(alkaliPumpPin, LOW);
-        digitalWrite(acidPumpPin, LOW);
-
-        // Включение устройств согласно этапу
-        switch(stage) {
-            case 1: // Холодное ополаскивание
-                digitalWrite(drainValvePin, HIGH);
-                digitalWrite(coldWaterValvePin, HIGH);
-                break;
-                
-            case 2: // Щелочная мойка
-                digitalWrite(alkaliPumpPin, HIGH);
-                digitalWrite(washPumpPin, HIGH);
-                break;
-                
-            case 3: // Промежуточное ополаскивание
-                digitalWrite(drainValvePin, HIGH); // Обычно слив открыт на ополаскивании
-                digitalWrite(hotWaterValvePin, HIGH);
-                break;
-                
-            case 4: // Кислотная мойка
-                digitalWrite(acidPumpPin, HIGH);
-                digitalWrite(washPumpPin, HIGH);
-                break;
-                
-            case 5: // Финальное ополаскивание
-                digitalWrite(drainValvePin, HIGH); // Обычно слив открыт на ополаскивании
-                digitalWrite(hotWaterValvePin, HIGH);
-                break;
+    uint32_t stageElapsed() const {
+        return (stalled ? stallStart : SystemTimer::getMillis()) - stageStartTime;
+    }
+
+    /*
+     * Пауза отсчета шага, пока блокировка удерживает хотя бы один его выход
+     * (например, кислота при включенной вручную щелочи): иначе шаг прошел бы
+     * по времени, не выполнившись. Возвращает true, пока пауза идет.
+     */
+    bool checkStall() {
+        bool held = (outputs.getHeld() & OUT_WASH_GROUP) != 0;
+        if (held == stalled) return stalled;
+        uint32_t now = SystemTimer::getMillis();
+        if (held) {
+            SystemTimer::disarm();
+            stallStart = now;
+            stalled = true;
+        } else {
+            stageStartTime += now - stallStart; // Пауза не засчитывается в шаг
+            stalled = false;
+            armStageDeadline();
         }
+        journalPending = true;
+        return stalled;
+    }
+
+    /*
+     * Обработчик дедлайна (вызывается из прерывания Timer1)
+     * Только переключает выходы; учет шага выполняет update()
+     */
+    static void onStageDeadline(void* context) {
+        WashingController* self = static_cast<WashingController*>(context);
+        self->outputs.apply(OUT_WASH_GROUP, self->pendingOutputs);
+        self->deadlineTime = SystemTimer::getMillis();
+        self->deadlineFired = true;
+    }
+
+    /*
+     * Проверка условия по температуре текущего шага
+     */
+    bool isTempReached() const {
+        return returnSensor.isSensorOK() &&
+               returnSensor.getTempCenti() >= (int16_t)step.minTemp * 100;
     }
 
 public:
     /*
      * Конструктор
-     * Параметры - пины управления устройствами
+     * returnSensorRef - датчик температуры обратной линии мойки
+     * outputsRef - банк выходов
+     * journalRef - журнал хода мойки
      */
-    WashingController(uint8_t drain, uint8_t cold, uint8_t hot,
-                      uint8_t wash, uint8_t alkali, uint8_t acid)
-        : drainValvePin(drain), coldWaterValvePin(cold), hotWaterValvePin(hot),
-          washPumpPin(wash), alkaliPumpPin(alkali), acidPumpPin(acid),
-          washingRunning(false), currentStage(0), stageStartTime(0)
+    WashingController(TemperatureSensor& returnSensorRef, OutputBank& outputsRef,
+                      WashJournal& journalRef)
+        : returnSensor(returnSensorRef), outputs(outputsRef), journal(journalRef),
+          washingRunning(false), activeRecipe(RECIPE_CUSTOM), currentStage(0),
+          step(), stageStartTime(0), waitingForTemp(false), tempFault(false),
+          stalled(false), stallStart(0),
+          pendingOutputs(0), deadlineFired(false), deadlineTime(0),
+          journalPending(false), lastCheckpoint(0)
     {
-        // Настройка пинов как выходов
-        pinMode(drainValvePin, OUTPUT);
-        pinMode(coldWaterValvePin, OUTPUT);
-        pinMode(hotWaterValvePin, OUTPUT);
-        pinMode(washPumpPin, OUTPUT);
-        pinMode(alkaliPumpPin, OUTPUT);
-        pinMode(acidPumpPin, OUTPUT);
-        
-        // Выключение всех устройств по умолчанию
-        digitalWrite(drainValvePin, LOW);
-        digitalWrite(coldWaterValvePin, LOW);
-        digitalWrite(hotWaterValvePin, LOW);
-        digitalWrite(washPumpPin, LOW);
-        digitalWrite(alkaliPumpPin, LOW);
-        digitalWrite(acidPumpPin, LOW);
+        // Все устройства выключены по умолчанию (OutputBank выключает все выходы)
+        resetCustomRecipe();
     }
 
     /*
      * Основной метод обновления состояния
      * Должен вызываться в главном цикле программы
+     * Выходы к этому моменту уже переключены по дедлайну; здесь ведется учет шагов
+     * и запись в журнал, поэтому вызывается и когда мойка не активна
      */
     void update() {
+        if (journalPending) {
+            journalPending = false;
+            writeJournal();
+        }
         if(!washingRunning) return;
-        
-        // Проверка завершения текущего этапа
-        if((millis() - stageStartTime) > (uint32_t)settings.stageTimes[currentStage-1] * 1000UL) {
-            nextStage();
+
+        if (deadlineFired) {
+            deadlineFired = false;
+            if (waitingForTemp) {
+                tempFault = true; // Раствор не прогрелся за таймаут - шаг пропускается
+            }
+            nextStage(deadlineTime);
+            return;
+        }
+
+        if (checkStall()) return;
+
+        if (waitingForTemp && isTempReached()) {
+            // Температура достигнута - начинаем отсчет длительности шага
+            waitingForTemp = false;
+            stageStartTime = SystemTimer::getMillis();
+            armStageDeadline();
+            journalPending = true;
+            return;
+        }
+
+        // Периодическая отметка прогресса шага (ограничивает частоту записи в EEPROM)
+        if (SystemTimer::getMillis() - lastCheckpoint >= WashJournal::CHECKPOINT_INTERVAL_MS) {
+            writeJournal();
         }
     }
 
     /*
-     * Запуск мойки
+     * Запуск мойки по выбранному в настройках рецепту
+     * Вызывается только из главного цикла (кнопка мойки - через очередь событий)
      */
     void startWashing() {
         if(washingRunning) return; // Если мойка уже запущена, ничего не делаем
-        
-        washingRunning = true;
-        currentStage = 1;
-        stageStartTime = millis();
-        activateStage(currentStage);
+        if(getStepCount(settings.recipe) == 0) return; // Пустой рецепт
+
+        beginRecipe(settings.recipe, 1, SystemTimer::getMillis());
     }
 
     /*
-     * Переход к следующему этапу
+     * Проверка, была ли мойка прервана сбросом (по журналу)
      */
-    void nextStage() {
-        if(++currentStage > 5) {
-            // Завершение мойки после 5 этапа
+    bool hasInterruptedWash() const {
+        return journal.isInterrupted();
+    }
+
+    /*
+     * Продолжение прерванной мойки с шага и времени из журнала
+     * Возвращает false, если продолжить нельзя (рецепт изменился)
+     */
+    bool resumeInterrupted() {
+        WashJournalRecord record;
+        if (washingRunning || !journal.last(record) || record.stage == 0) return false;
+        if (record.stage > getStepCount(record.recipe)) return false;
+
+        // Время, прошедшее до сброса, засчитывается: шаг продолжается, а не начинается заново
+        uint32_t now = SystemTimer::getMillis();
+        uint32_t elapsedMs = (uint32_t)record.elapsed * 1000UL;
+        beginRecipe(record.recipe, record.stage, now - elapsedMs);
+        tempFault = (record.flags & WASH_JOURNAL_TEMP_FAULT) != 0;
+        if (waitingForTemp && !(record.flags & WASH_JOURNAL_WAITING)) {
+            // Температура была достигнута до сброса - продолжаем отсчет длительности
+            waitingForTemp = false;
+            armStageDeadline();
+        }
+        return true;
+    }
+
+    /*
+     * Вымывание химии из линии (служебный рецепт RECIPE_RINSE_OUT)
+     */
+    void startRinseOut() {
+        if (washingRunning) return;
+        beginRecipe(RECIPE_RINSE_OUT, 1, SystemTimer::getMillis());
+    }
+
+    /*
+     * Переход к следующему шагу
+     * startTime - момент начала следующего шага (без параметра - сейчас)
+     */
+    void nextStage(uint32_t startTime) {
+        if(++currentStage > getStepCount(activeRecipe)) {
+            // Завершение мойки после последнего шага
             stopWashing();
             return;
         }
-        
-        stageStartTime = millis();
-        activateStage(currentStage);
+
+        activateStage(currentStage, startTime);
+    }
+
+    void nextStage() {
+        SystemTimer::disarm();
+        if (deadlineFired) {
+            // Дедлайн уже переключил выходы - засчитываем именно его
+            deadlineFired = false;
+            nextStage(deadlineTime);
+            return;
+        }
+        nextStage(SystemTimer::getMillis());
     }
 
     /*
      * Остановка мойки
      */
     void stopWashing() {
+        if (washingRunning) {
+            // После последнего шага currentStage уже за пределами рецепта
+            if (currentStage > getStepCount(activeRecipe)) {
+                EventLog::append(LOG_WASH_DONE, tempFault);
+            } else {
+                EventLog::append(LOG_WASH_STOP, currentStage);
+            }
+        }
+        SystemTimer::disarm();
         washingRunning = false;
         currentStage = 0;
-        // Выключение всех устройств
-        digitalWrite(drainValvePin, LOW);
-        digitalWrite(coldWaterValvePin, LOW);
-        digitalWrite(hotWaterValvePin, LOW);
-        digitalWrite(washPumpPin, LOW);
-        digitalWrite(alkaliPumpPin, LOW);
-        digitalWrite(acidPumpPin, LOW);
+        waitingForTemp = false;
+        stalled = false;
+        deadlineFired = false;
+        // Выключение всех устройств одной записью
+        outputs.apply(OUT_WASH_GROUP, 0);
+        journalPending = true; // Мойка больше не считается прерванной
     }
 
     /*
-     * Загрузка настроек из EEPROM
-     * Возвращает true, если настройки загружены успешно
+     * Сброс настроек к значениям по умолчанию (из SettingsStore)
+     * Пользовательский рецепт - копия полной мойки
      */
-    bool loadSettings() {
-        // Адрес после настроек компрессора и миксера
-        constexpr int address = sizeof(CoolerSettings) + sizeof(MixerSettings); 
-        EEPROMStorage::read(address, settings);
-        // Проверка контрольной суммы, если не совпадает, используем дефолтные
-        if(settings.checksum != calculateChecksum()) {
-            settings = WashingSettings(); // Сброс к настройкам по умолчанию
-            return false;
+    void resetSettings() {
+        settings = WashingSettings();
+        resetCustomRecipe();
+    }
+
+    /*
+     * Перенос настроек старой версии (из SettingsStore)
+     * Версия 0 - прошивка до рецептов: в начале структуры лежат uint16_t stageTimes[5],
+     * длительности этапов полной мойки; они переносятся в пользовательский рецепт
+     */
+    bool migrateSettings(uint8_t fromVersion) {
+        if (fromVersion != 0) return true;
+        uint16_t stageTimes[5];
+        memcpy(stageTimes, &settings, sizeof(stageTimes));
+        resetSettings(); // Пользовательский рецепт - полная мойка с теми же этапами
+        for (uint8_t i = 0; i < 5; i++) settings.customSteps[i].duration = stageTimes[i];
+        return true;
+    }
+
+    /*
+     * Проверка загруженных настроек (из SettingsStore)
+     * Возвращает false, если значения недопустимы
+     */
+    bool applySettings() const {
+        // RECIPE_RINSE_OUT - служебный, выбранным рецептом быть не может
+        if (settings.recipe >= RECIPE_COUNT || settings.recipe == RECIPE_RINSE_OUT) return false;
+        if (settings.customStepCount > RECIPE_MAX_STEPS) return false;
+        // Проверяются все ячейки: неиспользуемые становятся шагами при увеличении их числа
+        for (uint8_t i = 0; i < RECIPE_MAX_STEPS; i++) {
+            const RecipeStep& step = settings.customSteps[i];
+            if ((step.outputs & ~OUT_WASH_GROUP) != 0 || !RecipeCheck::stepValid(step)) return false;
         }
         return true;
     }
@@ -192,74 +414,91 @@ public:
      * Сохранение настроек в EEPROM
      */
     void saveSettings() {
-        settings.checksum = calculateChecksum();
-        constexpr int address = sizeof(CoolerSettings) + sizeof(MixerSettings);
-        EEPROMStorage::write(address, settings);
+        SettingsStore::save(SETTINGS_WASHER);
     }
 
     /*
      * Проверка работы мойки
      * Возвращает true, если мойка активна
      */
-    bool isRunning() const { 
-        return washingRunning; 
+    bool isRunning() const {
+        return washingRunning;
+    }
+
+    /*
+     * Проверка, была ли последняя мойка выполнена с ошибкой по температуре
+     */
+    bool hasTempFault() const {
+        return tempFault;
+    }
+
+    /*
+     * Проверка, ждет ли текущий шаг нужной температуры
+     */
+    bool isWaitingForTemp() const {
+        return washingRunning && waitingForTemp;
+    }
+
+    /*
+     * Получение текущего шага
+     * Возвращает номер шага (1..N) или 0 если мойка не активна
+     */
+    uint8_t getCurrentStage() const {
+        return currentStage;
     }
-    
+
     /*
-     * Получение текущего этапа
-     * Возвращает номер этапа (1-5) или 0 если мойка не активна
+     * Количество шагов рецепта
      */
-    uint8_t getCurrentStage() const { 
-        return currentStage; 
+    uint8_t getStepCount(uint8_t recipe) const {
+        if (recipe == RECIPE_CUSTOM) return settings.customStepCount;
+        if (recipe >= RECIPE_COUNT) return 0;
+        return pgm_read_byte(&builtinRecipes[recipe].stepCount);
     }
-    
+
     /*
-     * Получение названия текущего этапа
-     * Возвращает строку с названием этапа
+     * Получение названия текущего шага
+     * Возвращает строку с названием шага
      */
     const char* getStageName() const {
         static char buffer[16]; // Статический буфер для возвращаемой строки
-        if (currentStage > 0 && currentStage <= 5) {
-            strcpy_P(buffer, (const char*)pgm_read_word(&(stageNames[currentStage])));
-        } else {
-            strcpy_P(buffer, (const char*)pgm_read_word(&(stageNames[0]))); // "IDLE"
-        }
+        uint8_t name = (washingRunning && step.name < STEP_NAME_COUNT) ? step.name : (uint8_t)STEP_IDLE;
+        strcpy_P(buffer, (const char*)pgm_read_ptr(&stepNames[name]));
         return buffer;
     }
-    
+
     /*
-     * Получение оставшегося времени этапа
-     * Возвращает время в секундах
+     * Получение оставшегося времени шага
+     * Возвращает время в секундах (во время ожидания температуры - полную длительность)
      */
     int getTimeLeft() const {
         if(!washingRunning || currentStage == 0) return 0;
-        unsigned long elapsedStageTime = (millis() - stageStartTime) / 1000UL;
-        int timeLeft = settings.stageTimes[currentStage-1] - elapsedStageTime;
+        if(waitingForTemp) return step.duration;
+        unsigned long elapsedStageTime = stageElapsed() / 1000UL;
+        int timeLeft = step.duration - elapsedStageTime;
         return (timeLeft > 0) ? timeLeft : 0; // Возвращаем 0, если время уже вышло
     }
-    
+
+    /*
+     * Температура моющего раствора в обратной линии (°C)
+     * Возвращает NAN, если датчик неисправен
+     */
+    float getReturnTemp() const {
+        return returnSensor.isSensorOK() ? returnSensor.getTemp() : NAN;
+    }
+
     /*
      * Получение ссылки на настройки
      */
-    WashingSettings& getSettings() { 
-        return settings; 
+    WashingSettings& getSettings() {
+        return settings;
     }
-    
-    // Методы для ручного управления компонентами (для тестирования)
-    void setDrainValve(bool state) { digitalWrite(drainValvePin, state); }
-    void setColdWaterValve(bool state) { digitalWrite(coldWaterValvePin, state); }
-    void setHotWaterValve(bool state) { digitalWrite(hotWaterValvePin, state); }
-    void setWashPump(bool state) { digitalWrite(washPumpPin, state); }
-    void setAlkaliPump(bool state) { digitalWrite(alkaliPumpPin, state); }
-    void setAcidPump(bool state) { digitalWrite(acidPumpPin, state); }
-};
 
-// Инициализация названий этапов в PROGMEM
-const char* const WashingController::stageNames[6] PROGMEM = {
-    "IDLE",               // 0 - не активно
-    "COLD RINSE",         // 1 - холодное ополаскивание
-    "ALKALI WASH",        // 2 - щелочная мойка
-    "INTERM. RINSE",      // 3 - промежуточное ополаскивание
-    "ACID WASH",          // 4 - кислотная мойка
-    "FINAL RINSE"         // 5 - финальное ополаскивание
+    // Методы для ручного управления компонентами (для тестирования)
+    void setDrainValve(bool state) { outputs.set(OUT_DRAIN_VALVE, state); }
+    void setColdWaterValve(bool state) { outputs.set(OUT_COLD_WATER, state); }
+    void setHotWaterValve(bool state) { outputs.set(OUT_HOT_WATER, state); }
+    void setWashPump(bool state) { outputs.set(OUT_WASH_PUMP, state); }
+    void setAlkaliPump(bool state) { outputs.set(OUT_ALKALI_PUMP, state); }
+    void setAcidPump(bool state) { outputs.set(OUT_ACID_PUMP, state); }
 };
@@ -1,92 +1,280 @@
 #include <Arduino.h>
-#include <LiquidCrystal_I2C.h>
 #include <GyverNTC.h>
-#include <GyverButton.h>
-#include <avr/wdt.h> // Для Watchdog Timer
+#include "Pins.h"
+#include "OutputBank.h"
+#include "SystemTimer.h"
+#include "TaskScheduler.h"
+#include "TaskWatchdog.h"
+#include "MemoryMonitor.h"
+#include "InputEvent.h"
+#include "ButtonScanner.h"
 #include "Display.h"
-#include "TemperatureSensor.h"
+#include "SensorArray.h"
 #include "ButtonMenuHandler.h"
 #include "CoolerController.h"
 #include "MixerController.h"
 #include "WashingController.h"
-#include "EEPROMStorage.h"
+#include "WashJournal.h"
+#include "EventLog.h"
+#include "SettingsStore.h"
 #include "SafetySystem.h"
+#include "TempHistory.h"
+#include "Telemetry.h"
+#ifdef BENCHMARK
+#include "Benchmark.h"
+#endif
 
-// Определение пинов подключения
-#define TEMP_SENSOR_PIN A0
-#define COMPRESSOR_PIN 8
-#define MIXER_PIN 7
-#define WASH_BUTTON_PIN 2 // Пин для кнопки запуска мойки
-#define UP_BUTTON_PIN 3
-#define DOWN_BUTTON_PIN 4
-#define SET_BUTTON_PIN 6
-#define ESC_BUTTON_PIN 5
-#define DRAIN_VALVE_PIN 9
-#define COLD_WATER_VALVE_PIN 10
-#define HOT_WATER_VALVE_PIN 11
-#define WASH_PUMP_PIN 12
-#define ALKALI_PUMP_PIN 13
-#define ACID_PUMP_PIN A1
-
-// Константы
+#define LCD_I2C_ADDRESS 0x27 // Адрес PCF8574 дисплея
+
+// Периоды задач (мс)
+#define EVENTS_PERIOD 10            // Разбор событий ввода
+#define SENSORS_PERIOD 10           // Опрос датчиков (фильтр тактируется своими 100 мс)
+#define WASHER_PERIOD 10            // Учет шагов мойки
+#define COOLER_PERIOD 100           // Регулирование температуры
+#define MIXER_PERIOD 100            // Управление мешалкой
+#define UI_PERIOD 20                // Опрос кнопок и меню
 #define DISPLAY_UPDATE_INTERVAL 500 // Интервал обновления дисплея (мс)
+#define CONSOLE_PERIOD 50           // Разбор команд из Serial
+#define TELEMETRY_PERIOD 100        // Проверка периода телеметрии (TELEMETRY_INTERVAL)
+
+// Сроки задач под контролем TaskWatchdog (мс): с запасом на вывод истории в консоль
+#define SENSORS_DEADLINE 1000
+#define WASHER_DEADLINE 2000
+#define COOLER_DEADLINE 2000
+#define UI_DEADLINE 2000
+
+// Журнал мойки в EEPROM (отдельная область после настроек SettingsStore)
+#define WASH_JOURNAL_ADDRESS 128
+
+// Журнал событий в EEPROM (после журнала мойки до конца EEPROM)
+#define EVENT_LOG_ADDRESS (WASH_JOURNAL_ADDRESS + WashJournal::SIZE)
+static_assert(EVENT_LOG_ADDRESS + EventLog::SIZE <= E2END + 1, "Event log exceeds EEPROM");
+static_assert(SettingsLayout::end() <= WASH_JOURNAL_ADDRESS, "Settings overlap the wash journal");
+static_assert(SettingsLayout::end() <= EEPROMStorage::CACHE_SIZE, "Settings must fit the EEPROM cache");
+
+// Каждая структура настроек должна помещаться в емкость своего блока
+static_assert(sizeof(CoolerSettings) <= SettingsLayout::CAPACITY[SETTINGS_COOLER], "CoolerSettings too large");
+static_assert(sizeof(MixerSettings) <= SettingsLayout::CAPACITY[SETTINGS_MIXER], "MixerSettings too large");
+static_assert(sizeof(WashingSettings) <= SettingsLayout::CAPACITY[SETTINGS_WASHER], "WashingSettings too large");
+static_assert(sizeof(ProbeCalibration) <= SettingsLayout::CAPACITY[SETTINGS_CALIBRATION],
+              "ProbeCalibration too large");
+
+// Пины датчиков в порядке ProbeId
+const uint8_t probePins[PROBE_COUNT] = {
+    TANK_TOP_PROBE_PIN, TANK_BOTTOM_PROBE_PIN, WASH_RETURN_PROBE_PIN, AMBIENT_PROBE_PIN
+};
 
 // Глобальные объекты
-LiquidCrystal_I2C lcd(0x27, 16, 2); // Адрес 0x27, 16 символов, 2 строки
-TemperatureSensor tempSensor(TEMP_SENSOR_PIN);
-CoolerController cooler(tempSensor, COMPRESSOR_PIN);
-MixerController mixer(MIXER_PIN);
-WashingController washer(
-    DRAIN_VALVE_PIN, COLD_WATER_VALVE_PIN, HOT_WATER_VALVE_PIN,
-    WASH_PUMP_PIN, ALKALI_PUMP_PIN, ACID_PUMP_PIN);
-Display display(lcd);
+SensorArray sensors(probePins);
+OutputBank outputs; // Все выходы (пины - в Pins.h)
+CoolerController cooler(sensors, outputs);
+MixerController mixer(outputs);
+WashJournal journal(WASH_JOURNAL_ADDRESS);
+WashingController washer(sensors.probe(PROBE_WASH_RETURN), outputs, journal);
+Display display; // LCD 16x2 через PCF8574 (адрес LCD_I2C_ADDRESS)
 // Передаем все необходимые контроллеры и датчик в ButtonMenuHandler
-ButtonMenuHandler buttons(
-    UP_BUTTON_PIN, DOWN_BUTTON_PIN, SET_BUTTON_PIN, ESC_BUTTON_PIN,
-    display, cooler, mixer, washer, tempSensor);
+ButtonMenuHandler buttons(display, cooler, mixer, washer, sensors);
 SafetySystem safety;
+InputQueue inputEvents; // События кнопок из прерываний ButtonScanner
+
+/*
+ * Разбор событий кнопок: кнопка мойки запускает мойку, остальные идут в меню
+ * Здесь же в журнал попадают срабатывания блокировок выходов
+ * (OutputBank переключается и из прерываний, где журнал недоступен)
+ */
+void eventsTask() {
+    uint8_t violations = outputs.takeViolations();
+    if (violations) EventLog::append(LOG_INTERLOCK, violations);
+    EventLog::update(); // Отметка потерянных событий, когда очередь EEPROM освободится
 
-// Переменные состояния
-unsigned long lastDisplayUpdate = 0;
+    InputEvent event;
+    while (inputEvents.pop(event)) {
+        if (event.code == BUTTON_WASH) {
+            // Запускаем мойку только если меню не активно и мойка в данный момент не работает
+            if (event.type == INPUT_BUTTON_CLICK && !buttons.isMenuActive() && !washer.isRunning()) {
+                washer.startWashing();
+            }
+        } else {
+            buttons.handleInput(event);
+        }
+    }
+}
 
 /*
- * Обработчик прерывания для кнопки мойки
- * Вызывается при низком уровне сигнала на WASH_BUTTON_PIN (FALLING)
+ * Задачи регулирования: выполняются независимо от состояния меню и дисплея
  */
-void washButtonISR() {
-    // Запускаем мойку только если меню не активно и мойка в данный момент не работает
-    if (!buttons.isMenuActive() && !washer.isRunning()) {
-        washer.startWashing();
+void sensorsTask() { sensors.update(); }
+void washerTask() { washer.update(); }
+void coolerTask() {
+    cooler.update();
+#if TEMP_HISTORY
+    TempHistory::update(cooler.isControlSensorOK(), cooler.getControlTempCenti()); // Точка раз в 10 с
+#endif
+}
+void mixerTask() { mixer.update(cooler.isRunning()); }
+
+/*
+ * Задачи интерфейса: низший приоритет, меню не использует delay()
+ */
+void uiTask() { buttons.update(); } // Таймеры меню; нажатия приходят через eventsTask()
+
+void displayTask() {
+    display.flush(); // Повтор вывода после ошибки шины
+    // Главный экран обновляется, пока меню не активно
+    if (buttons.isMenuActive()) return;
+    if (washer.isRunning()) {
+        display.showWashingScreen(washer.getStageName(), washer.getTimeLeft());
+    } else {
+        buttons.showMainScreen();
     }
 }
 
+/*
+ * Команды отладки из Serial (один символ):
+ * p - отчет профилировщика задач (статистика после печати сбрасывается)
+ * d - байты, переданные на LCD по шине I2C, и ошибки шины
+ * m - свободная RAM (минимум за время работы, сейчас) и занятая куча
+ * l - журнал событий из EEPROM
+ * h - история температуры регулирования (час по 10 с, 8 часов по 5 минут)
+ * r - причина последнего сброса и задача, на которой сработал сторожевой таймер
+ * t - двоичная телеметрия (пакеты состояния с периодом TELEMETRY_INTERVAL): вкл/выкл
+ */
+void consoleTask() {
+    while (Serial.available() > 0) {
+        switch (Serial.read()) {
+#if TASK_PROFILER
+            case 'p': TaskScheduler::printReport(Serial); break;
+#endif
+            case 'd':
+                Serial.print(F("lcd bytes: "));
+                Serial.print(LcdDriver::getBytesSent());
+                Serial.print(F(" errors: "));
+                Serial.println(LcdDriver::getErrors());
+                break;
+            case 'm': MemoryMonitor::printReport(Serial); break;
+            case 'l': EventLog::print(Serial); break;
+            case 'r': TaskWatchdog::printReport(Serial); break;
+            case 't': Telemetry::setEnabled(!Telemetry::isEnabled()); break;
+#if TEMP_HISTORY
+            case 'h': TempHistory::print(Serial); break;
+#endif
+            default: break;
+        }
+    }
+}
+
+/*
+ * Двоичная телеметрия: пакет состояния с периодом TELEMETRY_INTERVAL
+ * Кадр не отправляется, если буфер передачи Serial занят (без ожидания)
+ */
+void telemetryTask() {
+    if (!Telemetry::isDue()) return;
+    TelemetryPacket packet;
+    for (uint8_t i = 0; i < PROBE_COUNT; i++) packet.temps[i] = sensors.getTempCenti(i);
+    packet.faults = sensors.getFaultMask();
+    packet.outputs = outputs.getState();
+    packet.held = outputs.getHeld();
+    packet.flags = (washer.isRunning() ? TELEMETRY_FLAG_WASHING : 0) |
+                   (washer.isWaitingForTemp() ? TELEMETRY_FLAG_WAITING : 0) |
+                   (washer.hasTempFault() ? TELEMETRY_FLAG_TEMP_FAULT : 0) |
+                   (cooler.isRunning() ? TELEMETRY_FLAG_COOLING : 0) |
+                   (mixer.isActive() ? TELEMETRY_FLAG_MIXING : 0);
+    packet.stage = washer.isRunning() ? washer.getCurrentStage() : 0;
+    packet.timeLeft = washer.getTimeLeft();
+    Telemetry::send(Serial, packet);
+}
+static_assert(sizeof(TelemetryPacket::temps) / sizeof(int16_t) == PROBE_COUNT,
+              "TelemetryPacket must carry every probe");
+
+// Функции блоков настроек для SettingsStore
+void resetCoolerSettings() { cooler.resetSettings(); }
+bool applyCoolerSettings() { return cooler.applySettings(); }
+void resetMixerSettings() { mixer.resetSettings(); }
+bool applyMixerSettings() { return mixer.applySettings(); }
+void resetWasherSettings() { washer.resetSettings(); }
+bool applyWasherSettings() { return washer.applySettings(); }
+bool migrateWasherSettings(uint8_t fromVersion) { return washer.migrateSettings(fromVersion); }
+void resetCalibration() { sensors.resetCalibration(); }
+bool applyCalibration() { return sensors.applyCalibration(); }
+
+// Реестр настроек: данные, размер, версия структуры, функции сброса, миграции и проверки
+const SettingsBlock settingsBlocks[SETTINGS_BLOCK_COUNT] = {
+    {&cooler.getSettings(),    sizeof(CoolerSettings),   1, resetCoolerSettings, nullptr, applyCoolerSettings},
+    {&mixer.getSettings(),     sizeof(MixerSettings),    1, resetMixerSettings,  nullptr, applyMixerSettings},
+    {&washer.getSettings(),    sizeof(WashingSettings),  1, resetWasherSettings, migrateWasherSettings, applyWasherSettings},
+    {&sensors.getCalibration(), sizeof(ProbeCalibration), 1, resetCalibration,   nullptr, applyCalibration}
+};
+
+// Названия задач в PROGMEM
+const char taskNameEvents[] PROGMEM = "events";
+const char taskNameSensors[] PROGMEM = "sensors";
+const char taskNameWasher[] PROGMEM = "washer";
+const char taskNameCooler[] PROGMEM = "cooler";
+const char taskNameMixer[] PROGMEM = "mixer";
+const char taskNameUi[] PROGMEM = "ui";
+const char taskNameDisplay[] PROGMEM = "display";
+const char taskNameConsole[] PROGMEM = "console";
+const char taskNameTelemetry[] PROGMEM = "telemetry";
+
+// Таблица задач: название, функция, период, приоритет (0 - высший), срок TaskWatchdog (0 - без контроля)
+Task tasks[] = {
+    {taskNameSensors, sensorsTask, SENSORS_PERIOD, 0, SENSORS_DEADLINE, 0, 0, 0, 0},
+    {taskNameEvents,  eventsTask,  EVENTS_PERIOD,  1, 0,                0, 0, 0, 0},
+    {taskNameWasher,  washerTask,  WASHER_PERIOD,  2, WASHER_DEADLINE,  0, 0, 0, 0},
+    {taskNameCooler,  coolerTask,  COOLER_PERIOD,  3, COOLER_DEADLINE,  0, 0, 0, 0},
+    {taskNameMixer,   mixerTask,   MIXER_PERIOD,   4, 0,                0, 0, 0, 0},
+    {taskNameUi,      uiTask,      UI_PERIOD,      5, UI_DEADLINE,      0, 0, 0, 0},
+    {taskNameDisplay, displayTask, DISPLAY_UPDATE_INTERVAL, 6, 0,       0, 0, 0, 0},
+    {taskNameConsole, consoleTask, CONSOLE_PERIOD, 7, 0,                0, 0, 0, 0},
+    {taskNameTelemetry, telemetryTask, TELEMETRY_PERIOD, 8, 0,          0, 0, 0, 0}
+};
+static_assert(sizeof(tasks) / sizeof(tasks[0]) <= TaskProfiler::MAX_TASKS,
+              "Too many tasks for TaskProfiler");
+
 /*
  * Функция setup - инициализация системы
  */
 void setup() {
-    //wdt_disable(); // Временно отключаем Watchdog Timer во время инициализации
-
     // Инициализация последовательного порта для отладки
     Serial.begin(115200);
     Serial.println("System starting...");
 
+#ifdef BENCHMARK
+    Benchmark::run(); // Замеры в тактах (окружение bench)
+#endif
+
+    // Запуск фонового опроса датчиков и системного таймера (после init() ядра Arduino)
+    sensors.begin();
+    SystemTimer::begin();
+
     // Инициализация дисплея
-    lcd.init();
-    lcd.backlight(); // Включаем подсветку
+    display.begin(LCD_I2C_ADDRESS);
     display.showMessage("Initializing...");
     delay(1000); // Показываем сообщение на короткое время
 
-    // Загрузка настроек из EEPROM для всех контроллеров
-    // Если загрузка не удалась (например, из-за неверной контрольной суммы), 
-    // контроллеры будут использовать дефолтные значения.
-    if (!cooler.loadSettings() || !mixer.loadSettings() || !washer.loadSettings()) {
+    // Кэш области настроек: дальше сохранение настроек не ждет EEPROM
+    EEPROMStorage::begin();
+
+    // Поиск головы журнала событий и запись о запуске
+    EventLog::begin(EVENT_LOG_ADDRESS);
+    EventLog::append(LOG_BOOT, TaskWatchdog::getResetFlags());
+    if (TaskWatchdog::getResetFlags() & _BV(WDRF)) {
+        uint8_t culprit = TaskWatchdog::getCulprit();
+        EventLog::append(LOG_WATCHDOG, (culprit == TaskScheduler::NO_TASK) ? -1 : culprit);
+    }
+
+    // Загрузка всех блоков настроек из EEPROM за один проход
+    // Поврежденный блок получает значения по умолчанию, остальные загружаются
+    if (!SettingsStore::load(settingsBlocks)) {
         display.showMessage("Load Settings Err");
         delay(2000);
     }
 
-    // Настройка прерывания для кнопки мойки
-    // Используем FALLING, если кнопка подключена к GND и имеет PULLUP-резистор
-    attachInterrupt(digitalPinToInterrupt(WASH_BUTTON_PIN), washButtonISR, FALLING);
+    // Поиск последней записи журнала мойки
+    journal.begin();
+
+    // Сканер кнопок (все кнопки, включая кнопку мойки, замыкают на GND)
+    ButtonScanner::begin(inputEvents);
 
     // Показываем, что система готова
     display.showMessage("System Ready");
@@ -96,46 +284,23 @@ void setup() {
     // Теперь вызываем showMainScreen() явно после того, как объект `buttons` полностью создан.
     buttons.showMainScreen(); 
 
-   // wdt_enable(WDTO_4S); // Включаем Watchdog Timer с таймаутом 4 секунды
+    // Мойка была прервана сбросом: продолжить или вымыть химию из линии
+    if (washer.hasInterruptedWash()) {
+        buttons.promptResume();
+    }
+
+    TaskScheduler::begin(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    MemoryMonitor::printReport(Serial); // Запас памяти после инициализации
+
+    // Сторожевой таймер - после всех delay() инициализации
+    TaskWatchdog::begin();
 }
 
 /*
  * Главный цикл программы
+ * Задачи запускает планировщик; между дедлайнами процессор простаивает
  */
 void loop() {
-    //wdt_reset(); // Сбрасываем Watchdog Timer, чтобы предотвратить перезагрузку
-
-    // Обновление состояния всех компонентов
-    buttons.update();    // Обработка кнопок и навигации по меню
-    tempSensor.update(); // Обновление показаний датчика температуры
-    //safety.updateActivity(); // Обновляем активность для SafetySystem (сброс таймера Watchdog)
-    //safety.checkActivity(); // Проверяем активность системы
-
-    // Основной режим работы (когда меню не активно)
-    if (!buttons.isMenuActive()) {
-        cooler.update(); // Обновление состояния контроллера охлаждения
-        mixer.update(cooler.isRunning()); // Обновление состояния миксера (зависит от компрессора)
-
-        if (washer.isRunning()) {
-            washer.update(); // Обновление состояния контроллера мойки
-        }
-
-        // Обновление дисплея с заданным интервалом
-        if (millis() - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL) {
-            if (washer.isRunning()) {
-                display.showWashingScreen(washer.getStageName(), washer.getTimeLeft());
-            } else {
-                buttons.showMainScreen(); // Обновляем главный экран
-            }
-            lastDisplayUpdate = millis();
-        }
-    }
-
-    // Небольшая задержка для снижения нагрузки, если система не занята
-    // Это предотвращает слишком быстрый цикл, что может быть полезно для экономии энергии
-    // и стабильности, но избегаем длительных блокирующих задержек.
-    // Если мойка или меню активны, задержка не нужна, т.к. система занята.
-    if (!washer.isRunning() && !buttons.isMenuActive()) {
-        delay(10); // Очень короткая неблокирующая задержка
-    }
-}
\ No newline at end of file
+    TaskWatchdog::service(); // WDT сбрасывается, только если контролируемые задачи живы
+    TaskScheduler::run();
+}
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Decode the controller's binary telemetry stream into CSV.
+
+Wire format (see src/Telemetry.h): 0x00, COBS(packet + CRC-16 LE), 0x00.
+CRC-16 is avr-libc's _crc16_update: reflected polynomial 0xA001, init 0xFFFF.
+Console text between frames is skipped: it fails COBS or CRC checks.
+
+Usage:
+    telemetry_decode.py capture.bin > out.csv      # recorded byte stream
+    telemetry_decode.py - < capture.bin            # stdin
+    telemetry_decode.py /dev/ttyUSB0 --baud 115200 # live port (needs pyserial)
+
+Tests against a recorded capture: python3 tools/test_telemetry_decode.py
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+TELEMETRY_STATE = 0x01
+PROBES = ("tank_top", "tank_bottom", "wash_return", "ambient")
+
+# TelemetryPacket: type, seq, uptime, temps[4], faults, outputs, held,
+# flags, stage, timeLeft, maxLate, jitter, overruns
+STATE = struct.Struct("<BBI4hBBBBBHHHH")
+
+OUTPUTS = ("compressor", "mixer", "drain", "cold_water", "hot_water",
+           "wash_pump", "alkali_pump", "acid_pump")
+FLAGS = ("washing", "waiting", "temp_fault", "cooling", "mixing")
+
+COLUMNS = (["seq", "uptime_s"] + ["%s_c" % p for p in PROBES] +
+           ["faults", "outputs", "held", "flags", "stage", "time_left_s",
+            "max_late_ms", "jitter_us", "overruns"])
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def cobs_decode(data):
+    """Return the decoded bytes, or None if the block is not valid COBS."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        end = i + code
+        if code == 0 or end > len(data):
+            return None
+        out += data[i + 1:end]
+        i = end
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(chunks):
+    """Split a byte stream on 0x00 delimiters, yielding non-empty blocks."""
+    pending = bytearray()
+    for chunk in chunks:
+        for byte in chunk:
+            if byte == 0:
+                if pending:
+                    yield bytes(pending)
+                    pending.clear()
+            else:
+                pending.append(byte)
+
+
+def decode(block):
+    """Decode one frame into a packet tuple, or None if it is not a state packet."""
+    payload = cobs_decode(block)
+    if payload is None or len(payload) != STATE.size + 2:
+        return None
+    body, crc = payload[:-2], payload[-2] | (payload[-1] << 8)
+    if crc16(body) != crc:
+        return None
+    packet = STATE.unpack(body)
+    if packet[0] != TELEMETRY_STATE:
+        return None
+    return packet
+
+
+def names(mask, labels):
+    return "|".join(label for bit, label in enumerate(labels) if mask & (1 << bit))
+
+
+def row(packet):
+    (_, seq, uptime, t0, t1, t2, t3, faults, outputs, held, flags, stage,
+     time_left, max_late, jitter, overruns) = packet
+    temps = ["" if faults & (1 << i) else "%.2f" % (t / 100.0)
+             for i, t in enumerate((t0, t1, t2, t3))]
+    return ([seq, "%.3f" % (uptime / 1000.0)] + temps +
+            [faults, names(outputs, OUTPUTS), names(held, OUTPUTS),
+             names(flags, FLAGS), stage, time_left, max_late, jitter, overruns])
+
+
+def read_chunks(source, baud):
+    if source == "-":
+        stream = sys.stdin.buffer
+    elif source.startswith("/dev/") or source.upper().startswith("COM"):
+        import serial  # pyserial, only needed for a live port
+        stream = serial.Serial(source, baud, timeout=1)
+    else:
+        stream = open(source, "rb")
+    while True:
+        chunk = stream.read(4096)
+        if chunk:
+            yield chunk
+        elif source == "-" or not hasattr(stream, "in_waiting"):
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="capture file, '-' for stdin, or serial port")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    writer = csv.writer(sys.stdout, lineterminator="\n")
+    writer.writerow(COLUMNS)
+    good = bad = lost = 0
+    last_seq = None
+    try:
+        for block in frames(read_chunks(args.source, args.baud)):
+            packet = decode(block)
+            if packet is None:
+                bad += 1
+                continue
+            seq = packet[1]
+            if last_seq is not None:
+                lost += (seq - last_seq - 1) & 0xFF
+            last_seq = seq
+            good += 1
+            writer.writerow(row(packet))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    print("packets: %d, skipped blocks: %d, lost packets: %d" % (good, bad, lost),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()